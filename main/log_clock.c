@@ -0,0 +1,114 @@
+#include "log_clock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+
+/*
+	Кеш поточної секунди. Оновлюється раз на секунду (gettimeofday + форматування поза lock),
+	між оновленнями — тільки esp_timer_get_time() і копія рядка під spinlock.
+	Після SNTP корекції база перераховується на наступній секунді.
+*/
+
+typedef struct {
+	uint32_t	sec;		// 0 — ще нічого
+	int64_t		base_us;	// esp_timer_get_time() на початку секунди sec
+	char		str[LOG_CLOCK_DATE_LEN + 1];
+} clock_cache_t;
+
+static clock_cache_t s_cache;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t format_sec(uint32_t sec, char *out, size_t cap)
+{
+	struct tm tm_now;
+	time_t t = (time_t)sec;
+
+	if (!localtime_r(&t, &tm_now)) return 0;
+	return strftime(out, cap, "%Y-%m-%d %H:%M:%S", &tm_now);
+}
+
+// Нова секунда: взяти wall clock і перерахувати базу
+static bool refresh(int64_t mono, uint32_t *sec, uint16_t *ms)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	if (tv.tv_sec < (time_t)LOG_CLOCK_VALID_SEC) return false;
+
+	clock_cache_t c = {
+		.sec = (uint32_t)tv.tv_sec,
+		.base_us = mono - tv.tv_usec,
+	};
+	if (format_sec(c.sec, c.str, sizeof(c.str)) != LOG_CLOCK_DATE_LEN) return false;
+
+	portENTER_CRITICAL(&s_lock);
+	s_cache = c;
+	portEXIT_CRITICAL(&s_lock);
+
+	*sec = c.sec;
+	*ms = (uint16_t)(tv.tv_usec / 1000);
+	return true;
+}
+
+bool log_clock_now(uint32_t *sec, uint16_t *ms)
+{
+	int64_t mono = esp_timer_get_time();
+	uint32_t c_sec;
+	int64_t base;
+
+	portENTER_CRITICAL(&s_lock);
+	c_sec = s_cache.sec;
+	base = s_cache.base_us;
+	portEXIT_CRITICAL(&s_lock);
+
+	int64_t d = mono - base;
+	if (c_sec != 0 && d >= 0 && d < 1000000) {
+		*sec = c_sec;
+		*ms = (uint16_t)(d / 1000);
+		return true;
+	}
+
+	if (refresh(mono, sec, ms)) return true;
+
+	*sec = 0;
+	*ms = 0;
+	return false;
+}
+
+size_t log_clock_format(uint32_t sec, char *out, size_t cap)
+{
+	if (sec < LOG_CLOCK_VALID_SEC || cap <= LOG_CLOCK_DATE_LEN) return 0;
+
+	bool hit = false;
+
+	portENTER_CRITICAL(&s_lock);
+	if (s_cache.sec == sec) {
+		memcpy(out, s_cache.str, LOG_CLOCK_DATE_LEN + 1);
+		hit = true;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	if (hit) return LOG_CLOCK_DATE_LEN;
+	return format_sec(sec, out, cap);
+}
+
+size_t log_clock_stamp(char *out, size_t cap)
+{
+	uint32_t sec;
+	uint16_t ms;
+
+	if (cap < LOG_CLOCK_STAMP_MAX || !log_clock_now(&sec, &ms)) return 0;
+
+	size_t n = log_clock_format(sec, out, cap);
+	if (n == 0) return 0;
+
+	n += (size_t)snprintf(out + n, cap - n, ".%03u", (unsigned)ms);
+	return n;
+}
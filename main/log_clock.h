@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Спільний годинник для лог-хуків:
+	- "YYYY-MM-DD HH:MM:SS" форматується раз на секунду (localtime_r/strftime з правилами TZ),
+	  всі рядки в межах секунди беруть готовий рядок з кешу
+	- мілісекунди — від esp_timer (монотонний) відносно початку поточної секунди,
+	  тож порядок рядків усередині секунди видно і він не стрибає назад
+*/
+
+#define LOG_CLOCK_DATE_LEN		19	// "YYYY-MM-DD HH:MM:SS"
+#define LOG_CLOCK_STAMP_MAX		24	// + ".mmm" + '\0'
+#define LOG_CLOCK_VALID_SEC		1577836800u	// 2020-01-01: раніше — час ще не синхронізований
+
+// Unix секунди і мілісекунди зараз. false (sec = ms = 0) — час ще не синхронізований.
+bool		log_clock_now(uint32_t *sec, uint16_t *ms);
+
+// "YYYY-MM-DD HH:MM:SS" для sec (поточна секунда — з кешу). 0 — sec невалідний або не влізло.
+size_t		log_clock_format(uint32_t sec, char *out, size_t cap);
+
+// "YYYY-MM-DD HH:MM:SS.mmm" зараз. 0 — час ще не синхронізований.
+size_t		log_clock_stamp(char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,346 @@
+#include "log_defer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_memory_utils.h"
+
+/*
+	pack і render проходять той самий fmt однаковим парсером специфікацій,
+	тож тип кожного аргументу відомий з обох боків і окремо не зберігається.
+*/
+
+#define SPEC_TEXT_MAX		16	// "%-08.3lld" і т.п.; довше — не відкладаємо
+
+typedef enum {
+	ARG_NONE = 0,		// "%%"
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_SIZE,
+	ARG_INTMAX,
+	ARG_PTRDIFF,
+	ARG_DOUBLE,
+	ARG_PTR,
+	ARG_STR,
+} arg_kind_t;
+
+typedef struct {
+	const char	*text;		// від '%' до conv включно
+	size_t		text_len;
+	uint8_t		stars;		// скільки '*' (ширина/точність) — окремі int аргументи
+	arg_kind_t	kind;
+} spec_t;
+
+// p — одразу після '%'. NULL — специфікацію не підтримуємо (форматуємо одразу).
+static const char *spec_parse(const char *p, spec_t *s)
+{
+	char lm[3] = {0};
+	size_t nlm = 0;
+
+	s->text = p - 1;
+	s->stars = 0;
+
+	if (*p == '%') {
+		s->kind = ARG_NONE;
+		s->text_len = 2;
+		return p + 1;
+	}
+
+	while (*p && strchr("-+ #0", *p)) p++;
+
+	if (*p == '*') {
+		s->stars++;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9') p++;
+	}
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			s->stars++;
+			p++;
+		} else {
+			while (*p >= '0' && *p <= '9') p++;
+		}
+	}
+
+	while (*p && strchr("hlzjtL", *p) && nlm < 2) lm[nlm++] = *p++;
+
+	char conv = *p;
+	if (!conv) return NULL;
+	p++;
+
+	switch (conv) {
+	case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+		if (conv == 'c' && nlm) return NULL;
+		if (nlm == 0 || lm[0] == 'h') s->kind = ARG_INT;
+		else if (nlm == 1 && lm[0] == 'l') s->kind = ARG_LONG;
+		else if (nlm == 2 && lm[0] == 'l' && lm[1] == 'l') s->kind = ARG_LLONG;
+		else if (nlm == 1 && lm[0] == 'z') s->kind = ARG_SIZE;
+		else if (nlm == 1 && lm[0] == 'j') s->kind = ARG_INTMAX;
+		else if (nlm == 1 && lm[0] == 't') s->kind = ARG_PTRDIFF;
+		else return NULL;
+		break;
+
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		if (nlm > 1 || (nlm == 1 && lm[0] != 'l')) return NULL;
+		s->kind = ARG_DOUBLE;
+		break;
+
+	case 'p':
+		if (nlm) return NULL;
+		s->kind = ARG_PTR;
+		break;
+
+	case 's':
+		if (nlm) return NULL;
+		s->kind = ARG_STR;
+		break;
+
+	default:
+		// %n, %ls, %Lf і все невідоме
+		return NULL;
+	}
+
+	s->text_len = (size_t)(p - s->text);
+	if (s->text_len > SPEC_TEXT_MAX) return NULL;
+	return p;
+}
+
+static size_t arg_size(arg_kind_t k)
+{
+	switch (k) {
+	case ARG_INT:		return sizeof(int);
+	case ARG_LONG:		return sizeof(long);
+	case ARG_LLONG:		return sizeof(long long);
+	case ARG_SIZE:		return sizeof(size_t);
+	case ARG_INTMAX:	return sizeof(intmax_t);
+	case ARG_PTRDIFF:	return sizeof(ptrdiff_t);
+	case ARG_DOUBLE:	return sizeof(double);
+	case ARG_PTR:		return sizeof(void *);
+	default:		return 0;
+	}
+}
+
+size_t log_defer_pack(const char *fmt, va_list ap, uint8_t *out, size_t cap)
+{
+	if (!fmt || !esp_ptr_in_drom(fmt) || cap < sizeof(fmt)) return 0;
+
+	va_list aq;
+	va_copy(aq, ap);
+
+	size_t o = 0;
+	bool ok = true;
+
+	memcpy(out, &fmt, sizeof(fmt));
+	o += sizeof(fmt);
+
+	for (const char *p = fmt; ok && *p; ) {
+		if (*p++ != '%') continue;
+
+		spec_t s;
+		p = spec_parse(p, &s);
+		if (!p) {
+			ok = false;
+			break;
+		}
+
+		for (uint8_t i = 0; i < s.stars; i++) {
+			int v = va_arg(aq, int);
+			if (o + sizeof(v) > cap) {
+				ok = false;
+				break;
+			}
+			memcpy(out + o, &v, sizeof(v));
+			o += sizeof(v);
+		}
+		if (!ok) break;
+
+		union {
+			int		i;
+			long		l;
+			long long	ll;
+			size_t		z;
+			intmax_t	j;
+			ptrdiff_t	t;
+			double		d;
+			const void	*ptr;
+		} v;
+
+		switch (s.kind) {
+		case ARG_NONE:		continue;
+		case ARG_INT:		v.i = va_arg(aq, int); break;
+		case ARG_LONG:		v.l = va_arg(aq, long); break;
+		case ARG_LLONG:		v.ll = va_arg(aq, long long); break;
+		case ARG_SIZE:		v.z = va_arg(aq, size_t); break;
+		case ARG_INTMAX:	v.j = va_arg(aq, intmax_t); break;
+		case ARG_PTRDIFF:	v.t = va_arg(aq, ptrdiff_t); break;
+		case ARG_DOUBLE:	v.d = va_arg(aq, double); break;
+		case ARG_PTR:		v.ptr = va_arg(aq, void *); break;
+
+		case ARG_STR: {
+			const char *str = va_arg(aq, const char *);
+			if (!str) str = "(null)";
+
+			// рядок з flash житиме завжди — досить вказівника
+			if (esp_ptr_in_drom(str)) {
+				if (o + 1 + sizeof(str) > cap) {
+					ok = false;
+					break;
+				}
+				out[o++] = 0;
+				memcpy(out + o, &str, sizeof(str));
+				o += sizeof(str);
+				continue;
+			}
+
+			size_t n = strnlen(str, LOG_DEFER_STR_MAX + 1);
+			if (n > LOG_DEFER_STR_MAX || o + 1 + n > cap) {
+				ok = false;
+				break;
+			}
+			// 0 зайнятий під "вказівник", тож порожній рядок — окремо (len 1 + '\0')
+			if (n == 0) {
+				out[o++] = 1;
+				out[o++] = '\0';
+				continue;
+			}
+			out[o++] = (uint8_t)n;
+			memcpy(out + o, str, n);
+			o += n;
+			continue;
+		}
+		}
+		if (!ok) break;
+
+		size_t n = arg_size(s.kind);
+		if (o + n > cap) {
+			ok = false;
+			break;
+		}
+		memcpy(out + o, &v, n);
+		o += n;
+	}
+
+	va_end(aq);
+	return ok ? o : 0;
+}
+
+// snprintf з накопиченням: o не виходить за cap - 1
+static size_t put_fmt(char *out, size_t cap, size_t o, int n)
+{
+	if (n <= 0) return o;
+	if ((size_t)n > cap - 1 - o) return cap - 1;
+	return o + (size_t)n;
+}
+
+size_t log_defer_render(const uint8_t *rec, size_t len, char *out, size_t cap)
+{
+	if (cap == 0) return 0;
+	out[0] = '\0';
+
+	const char *fmt;
+	if (len < sizeof(fmt)) return 0;
+	memcpy(&fmt, rec, sizeof(fmt));
+	if (!esp_ptr_in_drom(fmt)) return 0;
+
+	size_t i = sizeof(fmt);
+	size_t o = 0;
+
+	for (const char *p = fmt; *p && o < cap - 1; ) {
+		if (*p != '%') {
+			out[o++] = *p++;
+			continue;
+		}
+		p++;
+
+		spec_t s;
+		p = spec_parse(p, &s);
+		if (!p) return 0;	// pack такого не пропускає — запис битий
+
+		if (s.kind == ARG_NONE) {
+			out[o++] = '%';
+			continue;
+		}
+
+		// специфікація з '*', заміненими на числа
+		int stars[2] = {0};
+		for (uint8_t k = 0; k < s.stars; k++) {
+			if (i + sizeof(int) > len) return 0;
+			memcpy(&stars[k], rec + i, sizeof(int));
+			i += sizeof(int);
+		}
+
+		char spec[SPEC_TEXT_MAX + 24];
+		size_t sl = 0;
+		uint8_t k = 0;
+		for (size_t c = 0; c < s.text_len; c++) {
+			if (s.text[c] == '*') {
+				sl += (size_t)snprintf(spec + sl, sizeof(spec) - sl, "%d", stars[k++]);
+			} else {
+				spec[sl++] = s.text[c];
+			}
+		}
+		spec[sl] = '\0';
+
+		char *dst = out + o;
+		size_t room = cap - o;
+
+		if (s.kind == ARG_STR) {
+			if (i + 1 > len) return 0;
+			uint8_t n = rec[i++];
+			char str[LOG_DEFER_STR_MAX + 1];
+			const char *sp = str;
+
+			if (n == 0) {
+				if (i + sizeof(sp) > len) return 0;
+				memcpy(&sp, rec + i, sizeof(sp));
+				i += sizeof(sp);
+				if (!esp_ptr_in_drom(sp)) sp = "(?)";
+			} else {
+				if (n > LOG_DEFER_STR_MAX || i + n > len) return 0;
+				memcpy(str, rec + i, n);
+				str[n] = '\0';
+				i += n;
+			}
+			o = put_fmt(out, cap, o, snprintf(dst, room, spec, sp));
+			continue;
+		}
+
+		size_t an = arg_size(s.kind);
+		if (i + an > len) return 0;
+
+		union {
+			int		i;
+			long		l;
+			long long	ll;
+			size_t		z;
+			intmax_t	j;
+			ptrdiff_t	t;
+			double		d;
+			const void	*ptr;
+		} v;
+		memcpy(&v, rec + i, an);
+		i += an;
+
+		int n = 0;
+		switch (s.kind) {
+		case ARG_INT:		n = snprintf(dst, room, spec, v.i); break;
+		case ARG_LONG:		n = snprintf(dst, room, spec, v.l); break;
+		case ARG_LLONG:		n = snprintf(dst, room, spec, v.ll); break;
+		case ARG_SIZE:		n = snprintf(dst, room, spec, v.z); break;
+		case ARG_INTMAX:	n = snprintf(dst, room, spec, v.j); break;
+		case ARG_PTRDIFF:	n = snprintf(dst, room, spec, v.t); break;
+		case ARG_DOUBLE:	n = snprintf(dst, room, spec, v.d); break;
+		case ARG_PTR:		n = snprintf(dst, room, spec, v.ptr); break;
+		default:		break;
+		}
+		o = put_fmt(out, cap, o, n);
+	}
+
+	while (o > 0 && (out[o - 1] == '\n' || out[o - 1] == '\r')) o--;
+	out[o] = '\0';
+	return o;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Відкладене форматування рядків лога:
+	- замість vsnprintf у запис кладеться вказівник на fmt + сирі аргументи
+	- текст рендериться тільки коли запис читають (/log, /ws), більшість рядків ніхто не відкриває
+	- відкладаємо тільки якщо fmt у flash (DROM) — він живий весь час роботи прошивки;
+	  %s з DROM зберігається вказівником, інший %s — копією (до LOG_DEFER_STR_MAX)
+
+	Формат запису (байти, без вирівнювання):
+	  вказівник fmt, далі по кожному аргументу у порядку fmt:
+	  '*' ширина/точність і цілі — int/long/long long/size_t як є (розмір з fmt),
+	  double, %p — вказівник,
+	  %s — u8 0 + вказівник (DROM) або u8 довжина + байти (копія)
+*/
+
+#ifndef LOG_DEFER_MAX
+	#define LOG_DEFER_MAX			192	// байт аргументів на запис; більше — форматуємо одразу
+#endif
+
+#ifndef LOG_DEFER_STR_MAX
+	#define LOG_DEFER_STR_MAX		64	// довший %s не з DROM — форматуємо одразу
+#endif
+
+/*
+	Запакувати fmt + аргументи в out. 0 — відкласти не можна (fmt не в DROM, %n, %L,
+	невідома специфікація, не влізло) — тоді треба форматувати звичайним vsnprintf.
+*/
+size_t		log_defer_pack(const char *fmt, va_list ap, uint8_t *out, size_t cap);
+
+/*
+	Відрендерити запакований запис (копію з арени, вже перевірену seqlock-ом).
+	Пише не більше cap - 1 байт + '\0', кінцеві \r\n прибирає. Повертає довжину тексту;
+	0 — запис битий (напр. fmt вже не вказує в DROM).
+*/
+size_t		log_defer_render(const uint8_t *rec, size_t len, char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,299 @@
+#include "log_dict.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/*
+	Токени (байти):
+	0xxxxxxx			— літерал ASCII
+	0x80 b				— літерал b >= 0x80
+	0x81..0xBF lo hi		— збіг довжини (t - 0x81 + 3) = 3..65, відстань 16 біт
+	11LLLLdd d			— збіг довжини LLLL + 3 = 3..18, відстань 10 біт (dd << 8 | d)
+	Відстань — назад від поточного байта у [статичний | історія | поточний рядок].
+	Рядок у пакеті: довжина токенів (1 байт < 0x80, інакше 2: 1hhhhhhh llllllll) + токени.
+*/
+
+#define MIN_MATCH	3
+#define SHORT_MAX	18
+#define SHORT_DIST	1024
+#define LONG_MAX	65
+
+// Ближчі до кінця — частіші (коротша відстань). Змінювати тільки разом на всіх нодах і root.
+static const char s_static[] =
+	"ESP_ERR_TIMEOUT ESP_FAIL invalid timeout disconnected connected reason:"
+	"heap free stack bytes size len count seq failed error ok start stop "
+	"<MESH_EVENT_PARENT_CONNECTED> <MESH_EVENT_ROUTING_TABLE_ADD> layer:"
+	" parent: root:<ROOT> mesh_time: mesh_log: mesh_rx mesh_tx wifi: "
+	"log_http: stack_mon: uart_bridge: node0: RX TX -> ROOT: cnt=, payload=\""
+	" from 00:00:00:00:00:00 ms sec 0123456789"
+	"\033[0;31mE (\033[0;33mW (\033[0;32mI (\033[0m D (V (";
+
+#define STATIC_LEN	((uint32_t)(sizeof(s_static) - 1))
+
+static uint8_t vbyte(const log_dict_hist_t *h, uint32_t i)
+{
+	return (i < STATIC_LEN) ? (uint8_t)s_static[i] : h->buf[i - STATIC_LEN];
+}
+
+// місце під наступний рядок: лишаємо останні LOG_DICT_KEEP байт (однаково на обох боках)
+static bool hist_make_room(log_dict_hist_t *h)
+{
+	if (h->len <= LOG_DICT_HIST - LOG_DICT_LINE_MAX) return false;
+
+	memmove(h->buf, h->buf + h->len - LOG_DICT_KEEP, LOG_DICT_KEEP);
+	h->len = LOG_DICT_KEEP;
+	return true;
+}
+
+/* ----------------- Encoder (нода) ----------------- */
+
+static uint32_t hash3(const log_dict_hist_t *h, uint32_t i)
+{
+	uint32_t v = ((uint32_t)vbyte(h, i) << 16) | ((uint32_t)vbyte(h, i + 1) << 8) | vbyte(h, i + 2);
+	return (v * 2654435761u) >> (32 - LOG_DICT_HASH_BITS);
+}
+
+// хеші всіх позицій, де вже є 3 байти (до end)
+static void hash_range(log_dict_enc_t *e, uint32_t from, uint32_t end)
+{
+	for (uint32_t i = from; i + MIN_MATCH <= end; i++) {
+		e->head[hash3(&e->h, i)] = (uint16_t)(i + 1);
+	}
+}
+
+static void hash_rebuild(log_dict_enc_t *e)
+{
+	memset(e->head, 0, sizeof(e->head));
+	hash_range(e, 0, STATIC_LEN + e->h.len);
+}
+
+void log_dict_enc_reset(log_dict_enc_t *e)
+{
+	e->h.len = 0;
+	hash_rebuild(e);
+}
+
+size_t log_dict_encode(log_dict_enc_t *e, const char *line, size_t len, uint8_t *out)
+{
+	if (len > LOG_DICT_LINE_MAX) len = LOG_DICT_LINE_MAX;
+
+	if (hist_make_room(&e->h)) hash_rebuild(e);
+
+	// рядок стає частиною вікна ще до кодування — збіги всередині рядка теж працюють
+	uint32_t start = STATIC_LEN + e->h.len;
+	uint32_t end = start + (uint32_t)len;
+	memcpy(e->h.buf + e->h.len, line, len);
+
+	// хвіст позицій попереднього рядка, для яких тепер є 3 байти
+	hash_range(e, start >= 2 ? start - 2 : 0, start + 2 < end ? start + 2 : end);
+
+	uint8_t tok[2 * LOG_DICT_LINE_MAX];
+	size_t n = 0;
+
+	for (uint32_t p = start; p < end; ) {
+		uint32_t best = 0;
+		uint32_t dist = 0;
+
+		if (p + MIN_MATCH <= end) {
+			uint32_t h = hash3(&e->h, p);
+			uint32_t c = e->head[h];
+			e->head[h] = (uint16_t)(p + 1);
+
+			if (c && c - 1 < p) {
+				c -= 1;
+				uint32_t max = end - p;
+				if (max > LONG_MAX) max = LONG_MAX;
+				while (best < max && vbyte(&e->h, c + best) == vbyte(&e->h, p + best)) best++;
+				dist = p - c;
+			}
+		}
+
+		if (best >= MIN_MATCH) {
+			if (best <= SHORT_MAX && dist < SHORT_DIST) {
+				tok[n++] = (uint8_t)(0xC0 | ((best - MIN_MATCH) << 2) | (dist >> 8));
+				tok[n++] = (uint8_t)dist;
+			} else {
+				tok[n++] = (uint8_t)(0x81 + best - MIN_MATCH);
+				tok[n++] = (uint8_t)dist;
+				tok[n++] = (uint8_t)(dist >> 8);
+			}
+			hash_range(e, p + 1, p + best < end ? p + best + 2 : end);
+			p += best;
+		} else {
+			uint8_t b = vbyte(&e->h, p);
+			if (b >= 0x80) tok[n++] = 0x80;
+			tok[n++] = b;
+			p++;
+		}
+	}
+	e->h.len = (uint16_t)(e->h.len + len);
+
+	size_t o = 0;
+	if (n < 0x80) {
+		out[o++] = (uint8_t)n;
+	} else {
+		out[o++] = (uint8_t)(0x80 | (n >> 8));
+		out[o++] = (uint8_t)n;
+	}
+	memcpy(out + o, tok, n);
+	return o + n;
+}
+
+/* ----------------- Decoder (root) ----------------- */
+
+typedef struct {
+	bool		used;
+	bool		synced;		// історія відповідає next_seq
+	uint8_t		mac[6];
+	uint32_t	next_seq;
+	uint32_t	stamp;
+	log_dict_hist_t	*h;		// з heap на першу пачку; слот віддає його наступному стріму
+} rx_t;
+
+static rx_t s_rx[LOG_DICT_RX_MAX];
+static uint32_t s_rx_stamp = 0;
+static _Atomic uint32_t s_desync = 0;
+
+// Слот стріму mac; новий (used == false) — вільний або найдавніше активний
+static rx_t *rx_find(const uint8_t mac[6])
+{
+	rx_t *victim = &s_rx[0];
+
+	for (int i = 0; i < LOG_DICT_RX_MAX; i++) {
+		rx_t *x = &s_rx[i];
+		if (x->used && memcmp(x->mac, mac, 6) == 0) return x;
+		if (!x->used) {
+			if (victim->used) victim = x;
+		} else if (victim->used && (int32_t)(x->stamp - victim->stamp) < 0) {
+			victim = x;
+		}
+	}
+	// найдавніше активний стрім віддає місце (його наступний keyframe знову займе слот)
+	log_dict_hist_t *h = victim->h;
+	memset(victim, 0, sizeof(*victim));
+	victim->h = h;
+	return victim;
+}
+
+// Один рядок з data[*off]; false — битий
+static bool decode_line(log_dict_hist_t *h, const uint8_t *data, size_t len, size_t *off,
+			const char **line, size_t *line_len)
+{
+	size_t o = *off;
+	if (o >= len) return false;
+
+	size_t n = data[o++];
+	if (n & 0x80) {
+		if (o >= len) return false;
+		n = ((n & 0x7F) << 8) | data[o++];
+	}
+	if (n > len - o) return false;
+
+	const uint8_t *t = data + o;
+	const uint8_t *t_end = t + n;
+	*off = o + n;
+
+	hist_make_room(h);
+	uint32_t start = h->len;
+
+	while (t < t_end) {
+		uint8_t b = *t++;
+		uint32_t m = 1;
+		uint32_t dist = 0;
+
+		if (b < 0x80) {
+			if (h->len - start >= LOG_DICT_LINE_MAX) return false;
+			h->buf[h->len++] = b;
+			continue;
+		}
+		if (b == 0x80) {
+			if (t >= t_end || h->len - start >= LOG_DICT_LINE_MAX) return false;
+			h->buf[h->len++] = *t++;
+			continue;
+		}
+		if (b < 0xC0) {
+			if (t_end - t < 2) return false;
+			m = b - 0x81 + MIN_MATCH;
+			dist = (uint32_t)t[0] | ((uint32_t)t[1] << 8);
+			t += 2;
+		} else {
+			if (t >= t_end) return false;
+			m = ((b >> 2) & 0x0F) + MIN_MATCH;
+			dist = ((uint32_t)(b & 0x03) << 8) | *t++;
+		}
+
+		uint32_t cur = STATIC_LEN + h->len;
+		if (dist == 0 || dist > cur || h->len - start + m > LOG_DICT_LINE_MAX) return false;
+
+		// побайтово: збіг може перекривати сам себе
+		for (uint32_t i = 0; i < m; i++, cur++) {
+			h->buf[h->len++] = vbyte(h, cur - dist);
+		}
+	}
+
+	*line = (const char *)h->buf + start;
+	*line_len = h->len - start;
+	return true;
+}
+
+static log_dict_rx_t desync(rx_t *x)
+{
+	bool was = x->synced;
+	x->synced = false;
+	atomic_fetch_add_explicit(&s_desync, 1, memory_order_relaxed);
+	return was ? LOG_DICT_RX_LOST : LOG_DICT_RX_WAIT;
+}
+
+log_dict_rx_t log_dict_rx_batch(const uint8_t mac[6], uint32_t seq, bool key,
+				const uint8_t *data, size_t len, uint8_t count,
+				log_dict_line_cb_t on_line, void *ctx)
+{
+	rx_t *x = rx_find(mac);
+	x->stamp = ++s_rx_stamp;
+
+	if (!x->h) {
+		x->h = (log_dict_hist_t *)malloc(sizeof(*x->h));
+		if (!x->h) {
+			// без пам'яті CTRL не допоможе — просто не декодуємо, поки не звільниться
+			x->used = false;
+			atomic_fetch_add_explicit(&s_desync, 1, memory_order_relaxed);
+			return LOG_DICT_RX_WAIT;
+		}
+		x->h->len = 0;
+	}
+
+	if (!x->used) {
+		// стрім, якого ще не бачили (або витіснений): без keyframe не розгорнути
+		x->used = true;
+		memcpy(x->mac, mac, 6);
+		if (!key) {
+			atomic_fetch_add_explicit(&s_desync, 1, memory_order_relaxed);
+			return LOG_DICT_RX_LOST;
+		}
+	}
+
+	// без історії токени не розгорнути — чекаємо keyframe
+	if (!key && (!x->synced || x->next_seq != seq)) return desync(x);
+
+	if (key) x->h->len = 0;
+
+	size_t off = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		const char *line = NULL;
+		size_t n = 0;
+
+		// стан розійшовся з нодою (чи пакет битий)
+		if (!decode_line(x->h, data, len, &off, &line, &n)) return desync(x);
+		if (on_line) on_line(ctx, line, n);
+	}
+
+	x->synced = true;
+	x->next_seq = seq + count;
+	return LOG_DICT_RX_OK;
+}
+
+uint32_t log_dict_rx_desync(void)
+{
+	return atomic_load_explicit(&s_desync, memory_order_relaxed);
+}
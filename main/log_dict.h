@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "node_rings.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Стиснення рядків лога між нодою і root (MESH_LOG_TYPE_BATCH з MESH_LOG_BATCH_F_DICT).
+	- словник = статичний (однаковий у всіх прошивках: кольори ESP_LOG, "I (", теги, типові слова)
+	  + адаптивний: останні байти вже переданих рядків цього стріму (LOG_DICT_HIST)
+	- LZ77 по байтах: літерал, або (довжина, відстань назад) у [статичний | історія | поточний рядок]
+	- історія неперервна між пакетами: root декодує тільки пакет з очікуваним номером першого рядка
+	  або keyframe (історія з нуля), тож втрачений пакет коштує рядків до наступного keyframe
+	- ~LOG_DICT_HIST + хеш на ноді, LOG_DICT_RX_MAX * LOG_DICT_HIST на root (історія — з heap,
+	  коли стрім з'являється вперше, тож нода, що сама нічого не декодує, за це не платить)
+*/
+
+#ifndef LOG_DICT_HIST
+	#define LOG_DICT_HIST			1024	// адаптивна частина + поточний рядок
+#endif
+
+#ifndef LOG_DICT_KEEP
+	#define LOG_DICT_KEEP			512	// скільки історії лишати при зсуві
+#endif
+
+#ifndef LOG_DICT_HASH_BITS
+	#define LOG_DICT_HASH_BITS		9
+#endif
+
+#ifndef LOG_DICT_RX_MAX
+	#define LOG_DICT_RX_MAX			NODE_RINGS_MAX	// нод, чиї стріми root декодує одночасно
+#endif
+
+/*
+	Менше за кількість нод, що можуть стрімити разом (по ring-у на кожну), не можна: LRU у rx_find
+	витісняв би живий стрім на кожній пачці — LOST, CTRL, keyframe і знову по колу.
+*/
+_Static_assert(LOG_DICT_RX_MAX >= NODE_RINGS_MAX - 1, "LOG_DICT_RX_MAX < remote rings");
+
+#define LOG_DICT_LINE_MAX		255
+#define LOG_DICT_ENC_MAX		(2 + 2 * LOG_DICT_LINE_MAX)	// найгірший закодований рядок
+
+_Static_assert(LOG_DICT_KEEP + LOG_DICT_LINE_MAX <= LOG_DICT_HIST, "LOG_DICT_HIST too small");
+
+typedef struct {
+	uint16_t	len;
+	uint8_t		buf[LOG_DICT_HIST];
+} log_dict_hist_t;
+
+typedef struct {
+	log_dict_hist_t	h;
+	uint16_t	head[1u << LOG_DICT_HASH_BITS];	// позиція + 1 у [статичний | історія]
+} log_dict_enc_t;
+
+// Почати з нуля (keyframe)
+void		log_dict_enc_reset(log_dict_enc_t *e);
+
+// Закодувати рядок (len <= LOG_DICT_LINE_MAX) у out (>= LOG_DICT_ENC_MAX): довжина + токени. Повертає байти.
+size_t		log_dict_encode(log_dict_enc_t *e, const char *line, size_t len, uint8_t *out);
+
+/*
+	Root: розпакувати пакет ноди mac з першим рядком seq. key — keyframe.
+	Кожен рядок (без '\0') — у on_line. Тільки з однієї таски (mesh_rx_task).
+*/
+typedef void (*log_dict_line_cb_t)(void *ctx, const char *line, size_t len);
+
+typedef enum {
+	LOG_DICT_RX_OK = 0,
+	LOG_DICT_RX_LOST,	// історію щойно втрачено (або стрім новий) — варто попросити keyframe
+	LOG_DICT_RX_WAIT,	// вже чекаємо keyframe
+} log_dict_rx_t;
+
+log_dict_rx_t	log_dict_rx_batch(const uint8_t mac[6], uint32_t seq, bool key,
+				  const uint8_t *data, size_t len, uint8_t count,
+				  log_dict_line_cb_t on_line, void *ctx);
+
+// Пакетів, відкинутих через розсинхрон історії (LOST + WAIT)
+uint32_t	log_dict_rx_desync(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,491 @@
+#include "log_flash.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "log_flash";
+
+/*
+	Сектор: sect_hdr_t, далі записи flash_rec_t + текст (вирівняно на 4) до першого стертого (len = 0xFFFF).
+	Сектор seq завжди лежить на місці seq % кількість секторів, тож коло відновлюється з самих заголовків.
+	Запис ніколи не доходить впритул до кінця сектора — cursor з зсувом 0 завжди невалідний.
+	u32 cursor переповнюється після 4 GiB записаного — на порядки більше ресурсу flash.
+*/
+
+_Static_assert((LOG_FLASH_BLOCK & (LOG_FLASH_BLOCK - 1)) == 0, "LOG_FLASH_BLOCK must be a power of two");
+
+#define SECT_MAGIC		0x474F4C4Bu
+#define REC_MAGIC		0xA5
+#define REC_ERASED		0xFFFF
+
+typedef struct {
+	uint32_t	seq;
+	uint32_t	erases;		// скільки разів стирали цей сектор (переноситься зі старого заголовка)
+	uint32_t	first_ts;	// ts першого запису (0 — без часу)
+	uint32_t	magic;		// останнім: обірваний запис заголовка не виглядає валідним
+} sect_hdr_t;
+
+typedef struct {
+	uint16_t	len;		// REC_ERASED — далі в секторі нічого немає
+	uint16_t	crc;		// crc16 від ts..magic і тексту
+	uint32_t	ts;
+	uint16_t	ms;
+	uint8_t		level;
+	uint8_t		magic;
+} flash_rec_t;
+
+#define SECT_HDR		((uint32_t)sizeof(sect_hdr_t))
+#define REC_HDR			((uint32_t)sizeof(flash_rec_t))
+#define REC_ALIGN(x)		(((x) + 3u) & ~3u)
+#define REC_MAX			REC_ALIGN(REC_HDR + LOG_RING_LINE_MAX)
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_ss = 0;		// розмір сектора
+static uint32_t s_n = 0;		// секторів у розділі
+static SemaphoreHandle_t s_mtx = NULL;
+static log_ring_t *s_src = NULL;
+static bool s_ready = false;
+
+// Стан запису (змінює тільки таска, під s_mtx — бо його читають reader-и)
+static bool s_active = false;		// є відкритий сектор
+static uint32_t s_seq = 0;		// активний сектор
+static uint32_t s_oldest = 0;		// найстаріший сектор історії
+static uint32_t s_wr = 0;		// зсув наступного запису в активному секторі (разом із staged)
+static uint32_t s_flushed = 0;		// до цього зсуву все вже у flash
+static uint32_t s_last_flush_ms = 0;
+static uint8_t s_stage[LOG_FLASH_BLOCK + REC_MAX];	// байти сектора [s_flushed, s_wr)
+
+static uint32_t s_records = 0;
+static uint32_t s_dropped = 0;
+static uint32_t s_erases = 0;
+static uint32_t s_max_erase = 0;
+
+// таска читає ring у BIN: заголовок запису + текст
+static char s_rd[LOG_RING_LINE_MAX + LOG_RING_TEXT_PREFIX_MAX + 1];
+
+static uint32_t ms_now(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static uint32_t sect_addr(uint32_t seq)
+{
+	return (seq % s_n) * s_ss;
+}
+
+static bool sect_load(uint32_t seq, sect_hdr_t *h)
+{
+	if (esp_partition_read(s_part, sect_addr(seq), h, sizeof(*h)) != ESP_OK) return false;
+	return h->magic == SECT_MAGIC && h->seq == seq;
+}
+
+static uint16_t rec_crc(const flash_rec_t *h, const void *text, size_t len)
+{
+	uint16_t crc = esp_rom_crc16_le(0, (const uint8_t *)&h->ts, REC_HDR - offsetof(flash_rec_t, ts));
+	return esp_rom_crc16_le(crc, (const uint8_t *)text, (uint32_t)len);
+}
+
+static bool rec_hdr_ok(const flash_rec_t *h, uint32_t off)
+{
+	return h->len != REC_ERASED && h->magic == REC_MAGIC && h->len <= LOG_RING_LINE_MAX &&
+		off + REC_HDR + h->len <= s_ss;
+}
+
+/* ----------------- Відновлення після boot ----------------- */
+
+static void mount(void)
+{
+	bool any = false;
+	uint32_t newest = 0;
+
+	for (uint32_t i = 0; i < s_n; i++) {
+		sect_hdr_t h;
+		if (esp_partition_read(s_part, i * s_ss, &h, sizeof(h)) != ESP_OK) continue;
+		if (h.magic != SECT_MAGIC || (h.seq % s_n) != i) continue;
+
+		if (h.erases > s_max_erase) s_max_erase = h.erases;
+		if (!any || (int32_t)(h.seq - newest) > 0) newest = h.seq;
+		any = true;
+	}
+	if (!any) return;
+
+	// історія — безперервний ланцюжок seq до newest
+	uint32_t oldest = newest;
+	while (newest - oldest + 1 < s_n) {
+		sect_hdr_t h;
+		if (!sect_load(oldest - 1, &h)) break;
+		oldest--;
+	}
+
+	// кінець записаного в активному секторі
+	uint32_t off = SECT_HDR;
+	while (off + REC_HDR < s_ss) {
+		flash_rec_t h;
+		if (esp_partition_read(s_part, sect_addr(newest) + off, &h, sizeof(h)) != ESP_OK) break;
+		if (h.len == REC_ERASED) break;
+		if (!rec_hdr_ok(&h, off)) {
+			// обірваний запис (втрата живлення): дописувати поверх не можна — новий сектор
+			off = s_ss;
+			break;
+		}
+		off += REC_ALIGN(REC_HDR + h.len);
+	}
+
+	s_seq = newest;
+	s_oldest = oldest;
+	s_wr = off;
+	s_flushed = off;
+	s_active = true;
+}
+
+/* ----------------- Запис (таска) ----------------- */
+
+// під s_mtx. all = false — тільки цілі вирівняні блоки
+static void flush(bool all)
+{
+	uint32_t to = all ? s_wr : (s_wr & ~(uint32_t)(LOG_FLASH_BLOCK - 1));
+	if (to <= s_flushed) return;
+
+	uint32_t n = to - s_flushed;
+	if (esp_partition_write(s_part, sect_addr(s_seq) + s_flushed, s_stage, n) != ESP_OK) {
+		// стан сектора невідомий — наступний запис піде в новий
+		s_dropped++;
+		s_wr = s_ss;
+		s_flushed = s_ss;
+		return;
+	}
+
+	memmove(s_stage, s_stage + n, s_wr - to);
+	s_flushed = to;
+	s_last_flush_ms = ms_now();
+}
+
+// під s_mtx: стерти місце під seq (там був найстаріший сектор) і записати заголовок
+static bool open_sector(uint32_t seq, uint32_t first_ts)
+{
+	uint32_t addr = sect_addr(seq);
+	sect_hdr_t old;
+	uint32_t erases = 1;
+
+	if (esp_partition_read(s_part, addr, &old, sizeof(old)) == ESP_OK && old.magic == SECT_MAGIC) {
+		erases = old.erases + 1;
+	}
+	if (esp_partition_erase_range(s_part, addr, s_ss) != ESP_OK) return false;
+
+	sect_hdr_t h = {
+		.seq = seq,
+		.erases = erases,
+		.first_ts = first_ts,
+		.magic = SECT_MAGIC,
+	};
+	if (esp_partition_write(s_part, addr, &h, sizeof(h)) != ESP_OK) return false;
+
+	s_erases++;
+	if (erases > s_max_erase) s_max_erase = erases;
+
+	if (!s_active) {
+		s_oldest = seq;
+	} else if (seq - s_oldest >= s_n) {
+		s_oldest = seq - s_n + 1;
+	}
+	s_seq = seq;
+	s_wr = SECT_HDR;
+	s_flushed = SECT_HDR;
+	s_active = true;
+	return true;
+}
+
+// під s_mtx
+static void put_rec(uint32_t ts, uint16_t ms, uint8_t level, const char *text, size_t len)
+{
+	uint32_t need = REC_ALIGN(REC_HDR + (uint32_t)len);
+
+	// строго менше: запис не закінчується на межі сектора
+	if (!s_active || s_wr + need >= s_ss) {
+		flush(true);
+		if (!open_sector(s_active ? s_seq + 1 : s_seq, ts)) {
+			s_dropped++;
+			return;
+		}
+	}
+
+	flash_rec_t h = {
+		.len = (uint16_t)len,
+		.ts = ts,
+		.ms = ms,
+		.level = level,
+		.magic = REC_MAGIC,
+	};
+	h.crc = rec_crc(&h, text, len);
+
+	uint8_t *d = s_stage + (s_wr - s_flushed);
+	memcpy(d, &h, REC_HDR);
+	memcpy(d + REC_HDR, text, len);
+	memset(d + REC_HDR + len, 0xFF, need - REC_HDR - len);	// pad як стерта flash
+
+	s_wr += need;
+	s_records++;
+
+	if (s_wr - s_flushed >= LOG_FLASH_BLOCK) flush(false);
+}
+
+static void log_flash_task(void *arg)
+{
+	(void)arg;
+
+	uint32_t cursor = 1;	// невирівняний — ring віддасть усе, що є з boot
+	bool first = true;
+
+	for (;;) {
+		bool reset = false;
+		uint32_t end = log_ring_next(s_src);
+		size_t n;
+
+		while ((n = log_ring_read_fmt(s_src, &cursor, end, s_rd, sizeof(s_rd), &reset, LOG_RING_FMT_BIN, NULL)) > 0) {
+			xSemaphoreTake(s_mtx, portMAX_DELAY);
+			for (size_t i = 0; i + LOG_RING_BIN_HDR <= n; ) {
+				const uint8_t *b = (const uint8_t *)s_rd + i;
+				uint32_t ts = b[4] | (b[5] << 8) | (b[6] << 16) | ((uint32_t)b[7] << 24);
+				uint16_t ms = (uint16_t)(b[8] | (b[9] << 8));
+				uint16_t len = (uint16_t)(b[12] | (b[13] << 8));
+
+				put_rec(ts, ms, b[10], (const char *)b + LOG_RING_BIN_HDR, len);
+				i += LOG_RING_BIN_HDR + len;
+			}
+			xSemaphoreGive(s_mtx);
+		}
+
+		// ring обігнав нас (або /clear) — частина рядків у flash не потрапила
+		if (reset && !first) s_dropped++;
+		first = false;
+
+		if (s_wr > s_flushed && (ms_now() - s_last_flush_ms) >= LOG_FLASH_FLUSH_MS) {
+			xSemaphoreTake(s_mtx, portMAX_DELAY);
+			flush(true);
+			xSemaphoreGive(s_mtx);
+		}
+
+		vTaskDelay(pdMS_TO_TICKS(LOG_FLASH_POLL_MS));
+	}
+}
+
+/* ----------------- Читання (під s_mtx) ----------------- */
+
+static uint32_t oldest_cursor(void)
+{
+	return s_oldest * s_ss + SECT_HDR;
+}
+
+static uint32_t end_cursor(void)
+{
+	return s_seq * s_ss + s_flushed;
+}
+
+static bool cursor_valid(uint32_t c)
+{
+	uint32_t seq = c / s_ss;
+	uint32_t off = c % s_ss;
+
+	if ((int32_t)(seq - s_oldest) < 0 || (int32_t)(s_seq - seq) < 0) return false;
+	if (off < SECT_HDR || (off & 3)) return false;
+	if (seq == s_seq && off > s_flushed) return false;
+	return true;
+}
+
+// Заголовок запису на *c (або на початку наступного сектора). false — далі нічого не записано.
+static bool rec_load(uint32_t *c, flash_rec_t *h)
+{
+	for (;;) {
+		if (*c == end_cursor()) return false;
+
+		uint32_t seq = *c / s_ss;
+		uint32_t off = *c % s_ss;
+
+		if (off + REC_HDR < s_ss && !(seq == s_seq && off + REC_HDR > s_flushed)) {
+			if (esp_partition_read(s_part, sect_addr(seq) + off, h, sizeof(*h)) == ESP_OK && rec_hdr_ok(h, off)) {
+				// flush(false) пише до межі LOG_FLASH_BLOCK: заголовок уже у flash, а текст ще в s_stage —
+				// такий запис ще не віддаємо (інакше X-Log-Next за s_flushed і CRC по 0xFF)
+				if (seq != s_seq || off + REC_ALIGN(REC_HDR + h->len) <= s_flushed) return true;
+				return false;
+			}
+		}
+		if (seq == s_seq) return false;
+		*c = (seq + 1) * s_ss + SECT_HDR;
+	}
+}
+
+uint32_t log_flash_find_time(uint32_t since)
+{
+	if (!s_ready) return 0;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+
+	uint32_t c = 0;
+	if (s_active) {
+		// останній сектор, що почався не пізніше since (час може стрибати — без бінарного пошуку)
+		uint32_t best = s_oldest;
+		for (uint32_t seq = s_oldest; (int32_t)(s_seq - seq) >= 0; seq++) {
+			sect_hdr_t sh;
+			if (sect_load(seq, &sh) && sh.first_ts != 0 && sh.first_ts <= since) best = seq;
+		}
+
+		flash_rec_t h;
+		c = best * s_ss + SECT_HDR;
+		while (rec_load(&c, &h) && h.ts < since) {
+			c += REC_ALIGN(REC_HDR + h.len);
+		}
+	}
+
+	xSemaphoreGive(s_mtx);
+	return c;
+}
+
+uint32_t log_flash_frontier(uint32_t *cursor, uint32_t until, size_t max_bytes, bool *reset)
+{
+	if (!s_ready) return *cursor;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+
+	uint32_t c = *cursor;
+	if (s_active) {
+		if (!cursor_valid(c)) {
+			if (reset) *reset = true;
+			c = oldest_cursor();
+		}
+		*cursor = c;
+
+		// тільки заголовки записів
+		size_t bytes = 0;
+		flash_rec_t h;
+		while (rec_load(&c, &h)) {
+			if (until && h.ts > until) break;
+			if (bytes > 0 && bytes + h.len > max_bytes) break;
+			bytes += h.len;
+			c += REC_ALIGN(REC_HDR + h.len);
+		}
+	}
+
+	xSemaphoreGive(s_mtx);
+	return c;
+}
+
+size_t log_flash_read(uint32_t *cursor, uint32_t end, char *out, size_t cap, log_ring_fmt_t fmt)
+{
+	if (!s_ready) return 0;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+
+	size_t used = 0;
+	uint32_t c = *cursor;
+
+	// поки відповідали, найстаріший сектор могли стерти — тоді просто кінець відповіді
+	if (s_active && cursor_valid(c)) {
+		flash_rec_t h;
+		while ((int32_t)(end - c) > 0 && rec_load(&c, &h) && (int32_t)(end - c) > 0) {
+			if (used + LOG_RING_TEXT_PREFIX_MAX + h.len + 1 > cap) break;
+
+			log_rec_meta_t m = {
+				.ts = h.ts,
+				.ms = h.ms,
+				.level = h.level,
+			};
+			size_t pre = log_ring_fmt_prefix(fmt, c, &m, h.len, out + used);
+			uint32_t off = c % s_ss;
+			bool ok = esp_partition_read(s_part, sect_addr(c / s_ss) + off + REC_HDR, out + used + pre, h.len) == ESP_OK &&
+				rec_crc(&h, out + used + pre, h.len) == h.crc;
+
+			c += REC_ALIGN(REC_HDR + h.len);
+
+			// битий запис (обірваний при втраті живлення) — пропускаємо
+			if (!ok) continue;
+
+			used += pre + h.len;
+			if (fmt == LOG_RING_FMT_TEXT) out[used++] = '\n';
+		}
+		*cursor = c;
+	}
+
+	xSemaphoreGive(s_mtx);
+	return used;
+}
+
+void log_flash_get_stats(log_flash_stats_t *st)
+{
+	memset(st, 0, sizeof(*st));
+	if (!s_ready) return;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+
+	st->size = s_n * s_ss;
+	st->sectors = s_n;
+	st->records = s_records;
+	st->dropped = s_dropped;
+	st->erases = s_erases;
+	st->max_erase = s_max_erase;
+
+	if (s_active) {
+		sect_hdr_t sh;
+		st->oldest = oldest_cursor();
+		st->next = end_cursor();
+		if (sect_load(s_oldest, &sh)) st->oldest_ts = sh.first_ts;
+	}
+
+	xSemaphoreGive(s_mtx);
+}
+
+bool log_flash_ready(void)
+{
+	return s_ready;
+}
+
+esp_err_t log_flash_start(log_ring_t *src)
+{
+	if (s_ready) return ESP_OK;
+	if (!src) return ESP_ERR_INVALID_ARG;
+
+	const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LOG_FLASH_LABEL);
+	if (!p) return ESP_ERR_NOT_FOUND;
+
+	// записи дописуються в уже записаний сектор по 4 байти — з шифруванням flash так не можна
+	if (p->encrypted) {
+		ESP_LOGW(TAG, "partition '%s' is encrypted, history disabled", LOG_FLASH_LABEL);
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+
+	uint32_t ss = p->erase_size ? p->erase_size : 4096;
+	if (p->size / ss < 2 || ss < SECT_HDR + REC_MAX + LOG_FLASH_BLOCK) {
+		ESP_LOGW(TAG, "partition '%s' too small (%lu)", LOG_FLASH_LABEL, (unsigned long)p->size);
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	s_mtx = xSemaphoreCreateMutex();
+	if (!s_mtx) return ESP_ERR_NO_MEM;
+
+	s_part = p;
+	s_ss = ss;
+	s_n = p->size / ss;
+	s_src = src;
+	s_last_flush_ms = ms_now();
+
+	mount();
+
+	if (xTaskCreate(log_flash_task, "log_flash", 3072, NULL, 2, NULL) != pdPASS) {
+		vSemaphoreDelete(s_mtx);
+		s_mtx = NULL;
+		s_part = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+	s_ready = true;
+
+	ESP_LOGI(TAG, "history in '%s': %lu sectors, seq %lu..%lu",
+		LOG_FLASH_LABEL, (unsigned long)s_n, (unsigned long)s_oldest, (unsigned long)s_seq);
+	return ESP_OK;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "log_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Історія лога root у flash (переживає reboot і /clear).
+	- вмикається тільки якщо в таблиці розділів є data розділ з міткою LOG_FLASH_LABEL, напр.:
+	    logs,     data, 0x40,    ,        1M,
+	- таска читає local ring своїм cursor і пише записи блоками по LOG_FLASH_BLOCK (не по рядку)
+	- розділ — коло секторів: коли поточний повний, стирається найстаріший (рівномірне зношування,
+	  лічильник стирань — у заголовку сектора)
+	- cursor історії = seq сектора * розмір сектора + зсув у ньому (монотонний, як у log_ring);
+	  пошук за часом — по first_ts із заголовків секторів, без індексу в DRAM
+*/
+
+#ifndef LOG_FLASH_LABEL
+	#define LOG_FLASH_LABEL			"logs"
+#endif
+
+#ifndef LOG_FLASH_BLOCK
+	#define LOG_FLASH_BLOCK			1024	// запис у flash вирівняними шматками такого розміру
+#endif
+
+#ifndef LOG_FLASH_FLUSH_MS
+	#define LOG_FLASH_FLUSH_MS		10000	// неповний блок — не довше ніж стільки в RAM
+#endif
+
+#ifndef LOG_FLASH_POLL_MS
+	#define LOG_FLASH_POLL_MS		1000	// як часто таска забирає нове з ring
+#endif
+
+typedef struct {
+	uint32_t	size;		// розмір розділу
+	uint32_t	sectors;
+	uint32_t	oldest;		// cursor найстарішого запису
+	uint32_t	next;		// cursor після останнього записаного у flash
+	uint32_t	oldest_ts;	// first_ts найстарішого сектора (0 — невідомо)
+	uint32_t	records;	// записано з boot
+	uint32_t	dropped;	// розривів історії: ring обігнав таску, /clear або помилка flash
+	uint32_t	erases;		// стирань секторів з boot
+	uint32_t	max_erase;	// найбільший лічильник стирань серед секторів
+} log_flash_stats_t;
+
+// Знайти розділ, відновити позицію запису і запустити таску. ESP_ERR_NOT_FOUND — розділу немає.
+esp_err_t	log_flash_start(log_ring_t *src);
+
+bool		log_flash_ready(void);
+
+// cursor першого запису з ts >= since (записи без часу пропускаються)
+uint32_t	log_flash_find_time(uint32_t since);
+
+/*
+	Нормалізує *cursor (поза історією — *reset і найстаріший запис) і повертає межу відповіді:
+	не далі за записане, за перший запис з ts > until (0 — без межі) і не більше max_bytes тексту.
+*/
+uint32_t	log_flash_frontier(uint32_t *cursor, uint32_t until, size_t max_bytes, bool *reset);
+
+/*
+	Як log_ring_read_fmt: цілі записи з *cursor до end у форматі fmt, поки влазить у cap
+	(cap > LOG_RING_LINE_MAX + LOG_RING_TEXT_PREFIX_MAX). BIN cursor запису — cursor історії.
+*/
+size_t		log_flash_read(uint32_t *cursor, uint32_t end, char *out, size_t cap, log_ring_fmt_t fmt);
+
+void		log_flash_get_stats(log_flash_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,256 @@
+#include "log_gzip.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+_Static_assert((LOG_GZIP_WINDOW & (LOG_GZIP_WINDOW - 1)) == 0 && LOG_GZIP_WINDOW <= 32768 && LOG_GZIP_WINDOW >= 512,
+	"LOG_GZIP_WINDOW must be a power of two in [512, 32768]");
+
+/*
+	buf тримає до двох вікон: [0, pos) — вже закодовано (історія для збігів), [pos, len) — ще ні.
+	Коли buf повний — зсув на вікно. head/prev зберігають позицію + 1 у buf (0 — нема),
+	prev індексується pos & (WINDOW - 1), як у zlib.
+*/
+
+#define MIN_MATCH		3
+#define MAX_MATCH		258
+#define HASH_SIZE		(1u << LOG_GZIP_HASH_BITS)
+#define BUF_SIZE		(2 * LOG_GZIP_WINDOW)
+
+struct log_gzip {
+	log_gzip_sink_t	sink;
+	void		*ctx;
+	esp_err_t	err;
+	uint32_t	crc;
+	uint32_t	isize;
+	uint32_t	bits;		// бітовий буфер, молодші біти першими
+	uint32_t	nbits;
+	size_t		olen;
+	uint32_t	pos;
+	uint32_t	len;
+	uint16_t	head[HASH_SIZE];
+	uint16_t	prev[LOG_GZIP_WINDOW];
+	uint8_t		buf[BUF_SIZE];
+	uint8_t		out[LOG_GZIP_OUT];
+};
+
+// RFC 1951 3.2.5: коди довжин 257..285 і відстаней 0..29
+static const uint16_t s_len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t s_len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t s_dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t s_dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void out_flush(log_gzip_t *z)
+{
+	if (z->olen == 0) return;
+	if (z->err == ESP_OK) z->err = z->sink(z->ctx, z->out, z->olen);
+	z->olen = 0;
+}
+
+static void out_byte(log_gzip_t *z, uint8_t b)
+{
+	z->out[z->olen++] = b;
+	if (z->olen == sizeof(z->out)) out_flush(z);
+}
+
+static void put_bits(log_gzip_t *z, uint32_t v, uint32_t n)
+{
+	z->bits |= v << z->nbits;
+	z->nbits += n;
+	while (z->nbits >= 8) {
+		out_byte(z, (uint8_t)z->bits);
+		z->bits >>= 8;
+		z->nbits -= 8;
+	}
+}
+
+// коди Хаффмана пишуться старшим бітом вперед
+static void put_code(log_gzip_t *z, uint32_t code, uint32_t n)
+{
+	uint32_t r = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	put_bits(z, r, n);
+}
+
+// фіксовані коди літералів/довжин (RFC 1951 3.2.6)
+static void put_sym(log_gzip_t *z, uint32_t sym)
+{
+	if (sym < 144)		put_code(z, 0x30 + sym, 8);
+	else if (sym < 256)	put_code(z, 0x190 + (sym - 144), 9);
+	else if (sym < 280)	put_code(z, sym - 256, 7);
+	else			put_code(z, 0xC0 + (sym - 280), 8);
+}
+
+static void put_match(log_gzip_t *z, uint32_t len, uint32_t dist)
+{
+	uint32_t lc = 28;
+	while (s_len_base[lc] > len) lc--;
+	put_sym(z, 257 + lc);
+	if (s_len_extra[lc]) put_bits(z, len - s_len_base[lc], s_len_extra[lc]);
+
+	uint32_t dc = 29;
+	while (s_dist_base[dc] > dist) dc--;
+	put_code(z, dc, 5);
+	if (s_dist_extra[dc]) put_bits(z, dist - s_dist_base[dc], s_dist_extra[dc]);
+}
+
+static uint32_t hash3(const uint8_t *p)
+{
+	uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+	return (v * 2654435761u) >> (32 - LOG_GZIP_HASH_BITS);
+}
+
+static void insert(log_gzip_t *z, uint32_t p)
+{
+	if (p + MIN_MATCH > z->len) return;
+
+	uint32_t h = hash3(z->buf + p);
+	z->prev[p & (LOG_GZIP_WINDOW - 1)] = z->head[h];
+	z->head[h] = (uint16_t)(p + 1);
+}
+
+static uint32_t longest_match(log_gzip_t *z, uint32_t p, uint32_t *dist)
+{
+	uint32_t avail = z->len - p;
+	if (avail < MIN_MATCH) return 0;
+
+	uint32_t max = avail < MAX_MATCH ? avail : MAX_MATCH;
+	uint32_t best = 0;
+	uint32_t cand = z->head[hash3(z->buf + p)];
+
+	for (int chain = LOG_GZIP_CHAIN; cand && chain > 0; chain--) {
+		uint32_t c = cand - 1;
+		if (c >= p || p - c > LOG_GZIP_WINDOW) break;
+
+		const uint8_t *a = z->buf + c;
+		const uint8_t *b = z->buf + p;
+		uint32_t l = 0;
+		while (l < max && a[l] == b[l]) l++;
+
+		if (l > best) {
+			best = l;
+			*dist = p - c;
+			if (l == max) break;
+		}
+
+		// слот prev міг перезаписати новіший запис — ланцюжок має йти тільки назад
+		uint32_t next = z->prev[c & (LOG_GZIP_WINDOW - 1)];
+		if (next == 0 || next - 1 >= c) break;
+		cand = next;
+	}
+	return best >= MIN_MATCH ? best : 0;
+}
+
+// Закодувати [pos, len). Без flush лишаємо MAX_MATCH байт — збіг може продовжитись у наступному шматку.
+static void deflate_run(log_gzip_t *z, bool flush)
+{
+	while (z->pos < z->len && (flush || z->pos + MAX_MATCH <= z->len)) {
+		uint32_t dist = 0;
+		uint32_t l = longest_match(z, z->pos, &dist);
+
+		if (l) {
+			put_match(z, l, dist);
+			for (uint32_t i = 0; i < l; i++) insert(z, z->pos + i);
+			z->pos += l;
+		} else {
+			put_sym(z, z->buf[z->pos]);
+			insert(z, z->pos);
+			z->pos++;
+		}
+	}
+}
+
+// buf повний: викинути найстаріше вікно (pos вже за ним — див. deflate_run)
+static void slide(log_gzip_t *z)
+{
+	memmove(z->buf, z->buf + LOG_GZIP_WINDOW, z->len - LOG_GZIP_WINDOW);
+	z->len -= LOG_GZIP_WINDOW;
+	z->pos -= LOG_GZIP_WINDOW;
+
+	for (uint32_t i = 0; i < HASH_SIZE; i++) {
+		z->head[i] = z->head[i] > LOG_GZIP_WINDOW ? (uint16_t)(z->head[i] - LOG_GZIP_WINDOW) : 0;
+	}
+	for (uint32_t i = 0; i < LOG_GZIP_WINDOW; i++) {
+		z->prev[i] = z->prev[i] > LOG_GZIP_WINDOW ? (uint16_t)(z->prev[i] - LOG_GZIP_WINDOW) : 0;
+	}
+}
+
+log_gzip_t *log_gzip_begin(log_gzip_sink_t sink, void *ctx)
+{
+	log_gzip_t *z = (log_gzip_t *)calloc(1, sizeof(*z));
+	if (!z) return NULL;
+
+	z->sink = sink;
+	z->ctx = ctx;
+	z->err = ESP_OK;
+
+	// gzip: magic, deflate, без flags/mtime, xfl 0, OS 3 (unix)
+	static const uint8_t hdr[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+	for (size_t i = 0; i < sizeof(hdr); i++) out_byte(z, hdr[i]);
+
+	// один блок на весь потік: BFINAL = 1, BTYPE = 01 (фіксовані коди)
+	put_bits(z, 1, 1);
+	put_bits(z, 1, 2);
+	return z;
+}
+
+esp_err_t log_gzip_write(log_gzip_t *z, const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+
+	z->crc = esp_rom_crc32_le(z->crc, p, (uint32_t)len);
+	z->isize += (uint32_t)len;
+
+	while (len > 0 && z->err == ESP_OK) {
+		if (z->len == BUF_SIZE) slide(z);
+
+		size_t n = BUF_SIZE - z->len;
+		if (n > len) n = len;
+		memcpy(z->buf + z->len, p, n);
+		z->len += (uint32_t)n;
+		p += n;
+		len -= n;
+
+		deflate_run(z, false);
+	}
+	return z->err;
+}
+
+esp_err_t log_gzip_finish(log_gzip_t *z)
+{
+	deflate_run(z, true);
+	put_sym(z, 256);
+
+	// добити байт і трейлер: CRC32 і довжина, little-endian
+	if (z->nbits) put_bits(z, 0, 8 - z->nbits);
+	for (int i = 0; i < 4; i++) out_byte(z, (uint8_t)(z->crc >> (8 * i)));
+	for (int i = 0; i < 4; i++) out_byte(z, (uint8_t)(z->isize >> (8 * i)));
+	out_flush(z);
+
+	esp_err_t err = z->err;
+	free(z);
+	return err;
+}
+
+void log_gzip_abort(log_gzip_t *z)
+{
+	free(z);
+}
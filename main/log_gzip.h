@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Потоковий gzip для відповідей з логом (/log з Accept-Encoding: gzip, /log/download).
+	- deflate з фіксованими кодами Хаффмана (без таблиць у відповіді) і маленьким вікном LZ77:
+	  рядки лога повторюють час, рівень і tag, тож навіть так стискається в рази
+	- один блок на весь потік: дані йдуть у sink шматками по LOG_GZIP_OUT, без буферизації всієї відповіді
+	- стан ~ 3 * LOG_GZIP_WINDOW * 2 байт, з heap на час відповіді
+*/
+
+#ifndef LOG_GZIP_WINDOW
+	#define LOG_GZIP_WINDOW			2048	// степінь двійки, <= 32768
+#endif
+
+#ifndef LOG_GZIP_HASH_BITS
+	#define LOG_GZIP_HASH_BITS		11
+#endif
+
+#ifndef LOG_GZIP_CHAIN
+	#define LOG_GZIP_CHAIN			8	// скільки кандидатів перевіряти на позицію
+#endif
+
+#ifndef LOG_GZIP_OUT
+	#define LOG_GZIP_OUT			512	// шматок стиснутого виходу для sink
+#endif
+
+typedef esp_err_t (*log_gzip_sink_t)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct log_gzip log_gzip_t;
+
+// Почати потік (заголовок gzip піде з першим шматком). NULL — нема пам'яті.
+log_gzip_t	*log_gzip_begin(log_gzip_sink_t sink, void *ctx);
+
+// Стиснути ще шматок. Помилка sink зберігається і повертається далі.
+esp_err_t	log_gzip_write(log_gzip_t *z, const void *data, size_t len);
+
+// Дописати залишок і трейлер, звільнити стан. z після цього не використовувати.
+esp_err_t	log_gzip_finish(log_gzip_t *z);
+
+// Звільнити без трейлера (відповідь все одно обірвана)
+void		log_gzip_abort(log_gzip_t *z);
+
+#ifdef __cplusplus
+}
+#endif
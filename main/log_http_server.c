@@ -6,58 +6,106 @@
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stdatomic.h>
+#include <ctype.h>
 
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_err.h"
 #include "esp_mesh.h"
 #include "esp_wifi.h"
+#include "esp_random.h"
+#include "esp_system.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "freertos/portmacro.h"
 
 #include "mesh_proto.h"
+#include "log_ring.h"
+#include "log_defer.h"
+#include "log_flash.h"
+#include "log_gzip.h"
+#include "log_clock.h"
+#include "node_rings.h"
+#include "node_dir.h"
+#include "log_sessions.h"
+#include "log_resp_cache.h"
+#include "log_dict.h"
+#include "root_metrics.h"
+#include "stack_monitor.h"
 
 static const char *TAG = "log_http";
 
 /* ----------------- Налаштування ----------------- */
 
-#ifndef LOG_HTTP_LINES
-	#define LOG_HTTP_LINES			220
+#ifndef LOG_HTTP_RING_BYTES
+	#define LOG_HTTP_RING_BYTES		(32 * 1024)	// local ring, степінь двійки
 #endif
 
 #ifndef LOG_HTTP_LINE_MAX
-	#define LOG_HTTP_LINE_MAX		256
+	#define LOG_HTTP_LINE_MAX		LOG_RING_LINE_MAX
 #endif
 
-#ifndef LOG_HTTP_HEAP_MAX
-	#define LOG_HTTP_HEAP_MAX		512
+#ifndef LOG_HTTP_LINE_RESERVE
+	#define LOG_HTTP_LINE_RESERVE		256	// перший резерв під рядок hook-а; довший форматується вдруге
 #endif
 
-#ifndef LOG_HTTP_STACK_TMP
-	#define LOG_HTTP_STACK_TMP		128
+_Static_assert((LOG_HTTP_RING_BYTES & (LOG_HTTP_RING_BYTES - 1)) == 0, "LOG_HTTP_RING_BYTES must be a power of two");
+
+#ifndef LOG_HTTP_CHUNK
+	#define LOG_HTTP_CHUNK			1536	// шматок відповіді /log (має бути > LOG_RING_LINE_MAX)
+#endif
+
+_Static_assert(LOG_HTTP_CHUNK > LOG_RING_LINE_MAX + LOG_RING_TEXT_PREFIX_MAX, "LOG_HTTP_CHUNK must fit the longest ring line");
+
+#ifndef LOG_HTTP_HISTORY_MAX
+	#define LOG_HTTP_HISTORY_MAX		(64 * 1024)	// тексту в одній відповіді /log/history
+#endif
+
+#ifndef LOG_HTTP_GZIP_MIN
+	#define LOG_HTTP_GZIP_MIN		2048	// /log менше за стільки байт ring-а — без стиснення
+#endif
+
+#ifndef LOG_HTTP_GZIP_MAX
+	#define LOG_HTTP_GZIP_MAX		1	// одночасних gzip відповідей (стан ~12 KB кожна)
 #endif
 
-#ifndef WEB_POLL_MS
-	#define WEB_POLL_MS			500
+#ifndef LOG_HTTP_DEFER
+	#define LOG_HTTP_DEFER			1	// local ring: fmt + аргументи замість тексту (log_defer.h)
 #endif
 
-#ifndef LOG_HTTP_MAX_NODES
-	#define LOG_HTTP_MAX_NODES		24
+#ifndef LOG_HTTP_WAIT_MAX
+	#define LOG_HTTP_WAIT_MAX		4	// скільки /log?wait= може висіти одночасно
 #endif
 
-#define STR_HELPER(x)	#x
-#define STR(x)		STR_HELPER(x)
+#ifndef LOG_HTTP_WAIT_MAX_MS
+	#define LOG_HTTP_WAIT_MAX_MS		25000	// web/index.html: WAIT_MS
+#endif
+
+#ifndef LOG_HTTP_WAIT_COALESCE_MS
+	#define LOG_HTTP_WAIT_COALESCE_MS	30	// збираємо пачку рядків перед відповіддю
+#endif
+
+#ifndef LOG_HTTP_WS_MAX
+	#define LOG_HTTP_WS_MAX			4	// одночасних WebSocket дашбордів
+#endif
+
+// не вирівняний cursor: ring_start завжди дасть reset (напр. cursor з іншого ring)
+#define LOG_CURSOR_INVALID		1u
 
 /* ----------------- Стан ----------------- */
 
 static httpd_handle_t s_http_server = NULL;
 
-static portMUX_TYPE s_log_lock = portMUX_INITIALIZER_UNLOCKED;
-static char s_lines[LOG_HTTP_LINES][LOG_HTTP_LINE_MAX];
-static uint32_t s_write_idx = 0;	// абсолютний лічильник рядків (cursor)
-static uint32_t s_total_lines = 0;
+// Local ring: байтова арена з рядками змінної довжини (див. log_ring.h); cursor = байтова позиція.
+// Remote ноди мають свої ring-и в node_rings (під спільним бюджетом).
+static uint8_t s_ring_buf[LOG_HTTP_RING_BYTES] __attribute__((aligned(LOG_RING_ALIGN)));
+static log_ring_t s_ring = {
+	.buf	= s_ring_buf,
+	.size	= LOG_HTTP_RING_BYTES,
+};
 
 typedef int (*vprintf_like_t)(const char *fmt, va_list ap);
 static vprintf_like_t s_orig_vprintf = NULL;
@@ -66,24 +114,52 @@ static vprintf_like_t s_orig_vprintf = NULL;
 static uint8_t s_local_mac[6] = {0};
 static char s_local_tag[16] = "node0";
 
-// вибраний стрім (по замовчуванню local)
-static uint8_t s_sel_mac[6] = {0};
-static char s_sel_tag[16] = "node0";
+// вибір ноди — у сесії клієнта (log_sessions.h); без сесії — local
 
-// хто зараз реально стрімить (remote), щоб вимкнути попереднього
-static uint8_t s_stream_mac[6] = {0};
-static bool s_stream_active = false;
+// список remote нод — у node_dir
+static _Atomic uint32_t s_nodes_ver = 1;	// ++ коли змінюється те, що віддає /nodes
+static uint32_t s_boot_id = 0;			// для ETag /nodes (різний після кожного boot)
 
-// список нод
+// Що читає клієнт /log або /ws: позиція в конкретному ring, формат відповіді і фільтр
 typedef struct {
-	uint8_t mac[6];
-	char tag[16];
-	uint32_t last_seen_ms;
-} node_ent_t;
+	uint32_t		sess;		// сесія клієнта (її вибір, якщо нема node=); 0 — local
+	uint32_t		ring;		// gen ring-а, до якого належить cursor (0 — не перевіряти)
+	uint32_t		cursor;
+	log_ring_fmt_t		fmt;
+	bool			has_node;	// node= : конкретна нода замість вибраної сесією
+	uint8_t			node[6];
+	log_ring_filter_t	flt;
+	bool			gzip;		// клієнт приймає Content-Encoding: gzip
+} log_query_t;
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+// WebSocket дашборди: push нових рядків і змін /nodes (шле log_wait_task)
+typedef struct {
+	int		fd;		// -1 = вільно
+	log_query_t	q;
+	uint32_t	nodes_ver;
+} ws_client_t;
+
+static ws_client_t s_ws[LOG_HTTP_WS_MAX] = {
+	[0 ... LOG_HTTP_WS_MAX - 1] = { .fd = -1 }
+};
+static _Atomic uint32_t s_ws_count = 0;
+static portMUX_TYPE s_ws_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+// long-poll: запити, що чекають нових рядків (живуть у log_wait_task)
+typedef struct {
+	httpd_req_t	*req;		// async копія (httpd_req_async_handler_begin)
+	log_query_t	q;
+	TickType_t	deadline;
+} log_wait_t;
+
+static _Atomic uint32_t s_gzip_active = 0;
 
-static node_ent_t s_nodes[LOG_HTTP_MAX_NODES];
-static uint32_t s_nodes_count = 0;
-static portMUX_TYPE s_nodes_lock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t s_wait_q = NULL;
+static TaskHandle_t s_wait_task = NULL;
+static log_ring_scratch_t s_wait_tmp;	// рендер під фільтр у log_has_news — тільки log_wait_task
+static _Atomic uint32_t s_wait_parked = 0;
 
 /* ----------------- Helpers ----------------- */
 
@@ -102,149 +178,88 @@ static void mac_copy(uint8_t dst[6], const uint8_t src[6])
 	memcpy(dst, src, 6);
 }
 
-static void log_buffer_clear(void)
+static bool log_has_listeners(void)
 {
-	portENTER_CRITICAL(&s_log_lock);
-	{
-		s_write_idx = 0;
-		s_total_lines = 0;
-		memset(s_lines, 0, sizeof(s_lines));
-	}
-	portEXIT_CRITICAL(&s_log_lock);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+	if (atomic_load_explicit(&s_ws_count, memory_order_relaxed) > 0) return true;
+#endif
+	return atomic_load_explicit(&s_wait_parked, memory_order_relaxed) > 0;
 }
 
-static void log_buffer_append_line(const char *line, size_t len)
+// Розбудити long-poll/WS таску (дешево; нічого не робить, якщо ніхто не чекає)
+static void log_wait_kick(void)
 {
-	if (!line || len == 0) return;
-
-	// прибрати кінцеві \r \n
-	while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
-		len--;
-	}
-
-	// якщо після trim нічого не лишилось — не пишемо
-	if (len == 0) return;
-
-	portENTER_CRITICAL(&s_log_lock);
-	{
-		uint32_t idx = s_write_idx % LOG_HTTP_LINES;
-
-		size_t copy_len = (len >= (LOG_HTTP_LINE_MAX - 1)) ? (LOG_HTTP_LINE_MAX - 1) : len;
-		memcpy(s_lines[idx], line, copy_len);
-		s_lines[idx][copy_len] = '\0';
-
-		s_write_idx++;
-		if (s_total_lines < LOG_HTTP_LINES) s_total_lines++;
+	if (s_wait_task && log_has_listeners()) {
+		xTaskNotifyGive(s_wait_task);
 	}
-	portEXIT_CRITICAL(&s_log_lock);
 }
 
-
-static char *log_buffer_snapshot_since(uint32_t from, size_t *out_len, uint32_t *out_next, bool *out_reset)
+static void nodes_changed(void)
 {
-	char *snap = NULL;
-	size_t size = 0;
-
-	uint32_t next = 0;
-	uint32_t total = 0;
-	uint32_t earliest = 0;
-	uint32_t start_abs = 0;
-	uint32_t count = 0;
-	bool reset = false;
-
-	// 1) знімаємо стан (коротко) під lock
-	portENTER_CRITICAL(&s_log_lock);
-	{
-		next = s_write_idx;
-		total = s_total_lines;
-		earliest = (next >= total) ? (next - total) : 0;
-	}
-	portEXIT_CRITICAL(&s_log_lock);
-
-	// 2) нормалізація from
-	if (from < earliest || from > next) {
-		reset = true;
-		from = earliest;
-	}
-	start_abs = from;
-	count = (next > start_abs) ? (next - start_abs) : 0;
-
-	// 3) алокація під максимум
-	size = (size_t)count * (size_t)LOG_HTTP_LINE_MAX + 1;
-	snap = (char *)malloc(size);
-	if (!snap) {
-		if (out_len) *out_len = 0;
-		if (out_next) *out_next = next;
-		if (out_reset) *out_reset = true;
-		return NULL;
-	}
-
-	size_t pos = 0;
-
-	// 4) копіюємо рядки під lock (щоб не рвалися)
-	portENTER_CRITICAL(&s_log_lock);
-	{
-		// якщо за час алокації щось змінилось — перерахуй earliest/next “на льоту”
-		next = s_write_idx;
-		total = s_total_lines;
-		earliest = (next >= total) ? (next - total) : 0;
+	atomic_fetch_add_explicit(&s_nodes_ver, 1, memory_order_relaxed);
+	log_wait_kick();
+}
 
-		// якщо наш start_abs вже випав — ресет
-		if (start_abs < earliest || start_abs > next) {
-			reset = true;
-			start_abs = earliest;
-		}
+// Ring, вибраний сесією (refs++, потім node_rings_release). NULL — ще не створений або витіснений.
+static log_ring_t *sess_ring_acquire(uint32_t sess, uint32_t *gen)
+{
+	uint8_t mac[6];
+	log_sessions_get(sess, mac, NULL, 0);
+	return node_rings_acquire(mac, gen);
+}
 
-		for (uint32_t abs_i = start_abs; abs_i < next; abs_i++) {
-			uint32_t idx = abs_i % LOG_HTTP_LINES;
-			const char *line = s_lines[idx];
-			size_t l = strnlen(line, LOG_HTTP_LINE_MAX);
+// cursor клієнта має сенс тільки в тому ring, з якого він отриманий (want_gen == 0 — не перевіряємо)
+static uint32_t cursor_for(uint32_t want_gen, uint32_t gen, uint32_t from)
+{
+	return (want_gen && want_gen != gen) ? LOG_CURSOR_INVALID : from;
+}
 
-			if (pos + l + 2 >= size) break;
+static void log_buffer_clear(uint32_t sess)
+{
+	log_ring_t *r = sess_ring_acquire(sess, NULL);
+	if (!r) return;
 
-			memcpy(snap + pos, line, l);
-			pos += l;
+	log_ring_clear(r);
+	node_rings_release(r);
+	log_wait_kick();
+}
 
-			// newline нормалізація
-			if (pos == 0 || snap[pos - 1] != '\n') {
-				snap[pos++] = '\n';
-			}
-		}
+static size_t trim_eol(const char *line, size_t len)
+{
+	while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+		len--;
 	}
-	portEXIT_CRITICAL(&s_log_lock);
-
-	snap[pos] = '\0';
+	return len;
+}
 
-	if (out_len) *out_len = pos;
-	if (out_next) *out_next = next;
-	if (out_reset) *out_reset = reset;
-	return snap;
+// Час і метадані запису (час рендериться в "[...]" тільки при читанні TEXT)
+static void log_meta_now(log_rec_meta_t *m, const char *line, size_t len)
+{
+	log_clock_now(&m->ts, &m->ms);	// 0 — час ще не синхронізований
+	m->deferred = false;
+	log_ring_parse_line(line, len, m);
 }
 
-static bool build_time_prefix(char *out, size_t out_sz)
+static void log_buffer_append_line(log_ring_t *r, const char *line, size_t len)
 {
-	if (!out || out_sz == 0) return false;
+	if (!line || len == 0) return;
 
-	time_t now = time(NULL);
-	if (now <= 0) {
-		snprintf(out, out_sz, "[no-time] ");
-		return true;
-	}
+	// прибрати кінцеві \r \n
+	len = trim_eol(line, len);
 
-	struct tm tm_now;
-	if (!localtime_r(&now, &tm_now)) {
-		snprintf(out, out_sz, "[no-time] ");
-		return true;
-	}
+	// якщо після trim нічого не лишилось — не пишемо
+	if (len == 0) return;
 
-	size_t n = strftime(out, out_sz, "[%Y-%m-%d %H:%M:%S] ", &tm_now);
-	if (n == 0) snprintf(out, out_sz, "[no-time] ");
-	return true;
+	log_rec_meta_t meta;
+	log_meta_now(&meta, line, len);
+	log_ring_append(r, line, len, &meta);
 }
 
 /* ----------------- Mesh CTRL (root -> node) ----------------- */
 
-static void mesh_send_log_ctrl(const uint8_t to_mac[6], bool enable)
+_Static_assert(NODE_DIR_FLT_TAGS == sizeof(((mesh_log_ctrl_packet_t *)0)->tags), "NODE_DIR_FLT_TAGS");
+
+static void mesh_send_log_ctrl(const uint8_t to_mac[6], bool enable, uint8_t flags)
 {
 	mesh_log_ctrl_packet_t p;
 	memset(&p, 0, sizeof(p));
@@ -256,6 +271,17 @@ static void mesh_send_log_ctrl(const uint8_t to_mac[6], bool enable)
 	esp_wifi_get_mac(WIFI_IF_STA, p.h.src_mac);
 
 	p.enable = enable ? 1 : 0;
+	p.flags = flags;
+	p.rate_lps = enable ? NODE_DIR_RATE_LPS : 0;	// нода обмежує себе сама, root лише підстраховує
+	p.rate_burst = NODE_DIR_RATE_BURST;		// той самий bucket, що й у node_dir
+
+	// фільтр з /stream — нода відкидає зайве ще до черги
+	node_dir_ent_t e;
+	if (enable && node_dir_get(to_mac, &e)) {
+		p.max_level = e.flt_level;
+		p.tag_mode = e.flt_mode;
+		memcpy(p.tags, e.flt_tags, sizeof(p.tags));
+	}
 
 	mesh_data_t data;
 	memset(&data, 0, sizeof(data));
@@ -272,41 +298,38 @@ static void mesh_send_log_ctrl(const uint8_t to_mac[6], bool enable)
 	esp_mesh_send(&dest, &data, MESH_DATA_P2P, NULL, 0);
 }
 
-static void select_stream_node(const uint8_t mac[6], const char *tag)
+// node_rings витіснив ring — без глядачів стрім більше не потрібен
+static void on_ring_evicted(const uint8_t mac[6])
 {
-	// якщо вже вибрано це саме — нічого не робимо (щоб не смикати CTRL)
-	if (mac_eq(mac, s_sel_mac)) {
-		if (tag && tag[0]) {
-			strncpy(s_sel_tag, tag, sizeof(s_sel_tag) - 1);
-			s_sel_tag[sizeof(s_sel_tag) - 1] = '\0';
-		}
-		return;
-	}
-
-	// Вимкнути попередній remote стрім
-	if (s_stream_active) {
-		mesh_send_log_ctrl(s_stream_mac, false);
-		s_stream_active = false;
-		memset(s_stream_mac, 0, sizeof(s_stream_mac));
-	}
-
-	// Встановити вибір
-	mac_copy(s_sel_mac, mac);
-	strncpy(s_sel_tag, tag ? tag : "node", sizeof(s_sel_tag) - 1);
-	s_sel_tag[sizeof(s_sel_tag) - 1] = '\0';
+	if (log_sessions_viewers(mac) == 0) mesh_send_log_ctrl(mac, false, 0);
+}
 
-	// Очистити буфер під нову ноду
-	log_buffer_clear();
+/*
+	Глядачі ноди (сесії, що її вибрали). Стрім з ноди — один на всіх:
+	CTRL enable на першого глядача, disable — коли пішов останній. Ring при цьому
+	не чиститься: повернувшись, глядач бачить історію до паузи.
+*/
+static void on_session_view(const uint8_t mac[6], int delta, uint16_t viewers)
+{
+	bool local = mac_eq(mac, s_local_mac);
 
-	// Якщо вибір не local — увімкнути стрім на тій ноді
-	if (!mac_eq(s_sel_mac, s_local_mac)) {
-		mesh_send_log_ctrl(s_sel_mac, true);
-		s_stream_active = true;
-		mac_copy(s_stream_mac, s_sel_mac);
+	if (delta > 0) {
+		if (!local) {
+			log_ring_t *r = node_rings_open(mac, NULL, NULL);
+			node_rings_release(r);
+		}
+		node_rings_view(mac, +1);
+		if (!local && viewers == 1) mesh_send_log_ctrl(mac, true, 0);
+	} else {
+		node_rings_view(mac, -1);
+		if (!local && viewers == 0) mesh_send_log_ctrl(mac, false, 0);
 	}
+
+	// у /nodes кожної сесії свій selected_mac
+	nodes_changed();
 }
 
-/* ----------------- vprintf hook (тільки local, якщо local вибраний) ----------------- */
+/* ----------------- vprintf hook (local ring, завжди) ----------------- */
 
 static int log_http_vprintf(const char *fmt, va_list ap)
 {
@@ -320,159 +343,463 @@ static int log_http_vprintf(const char *fmt, va_list ap)
 		va_end(ap_copy);
 	}
 
-	// 2) У буфер пишемо ТІЛЬКИ якщо зараз вибрана local нода
-	if (!mac_eq(s_sel_mac, s_local_mac)) {
-		return ret;
+#if LOG_HTTP_DEFER
+	// 2) fmt з flash + аргументи — без форматування; текст буде тільки якщо рядок хтось прочитає
+	{
+		uint8_t raw[LOG_DEFER_MAX];
+		size_t n = log_defer_pack(fmt, ap, raw, sizeof(raw));
+
+		if (n > 0) {
+			log_rec_meta_t meta;
+			log_meta_now(&meta, fmt, strnlen(fmt, LOG_RING_TAG_MAX));	// рівень видно вже з fmt
+			meta.deferred = true;
+			log_ring_append(&s_ring, (const char *)raw, n, &meta);
+			log_wait_kick();
+			return ret;
+		}
 	}
+#endif
 
-	char tprefix[40];
-	build_time_prefix(tprefix, sizeof(tprefix));
-	size_t tlen = strnlen(tprefix, sizeof(tprefix));
-
-	char stack_buf[LOG_HTTP_STACK_TMP];
-	size_t cap = sizeof(stack_buf);
-
-	size_t copy_t = (tlen < (cap - 1)) ? tlen : (cap - 1);
-	memcpy(stack_buf, tprefix, copy_t);
-	stack_buf[copy_t] = '\0';
+	// 3) Резервуємо місце в арені і форматуємо прямо в нього (без heap і без другої копії);
+	//    час і рівень — у заголовок запису, не в текст
+	log_ring_wr_t wr;
+	char *dst = log_ring_reserve(&s_ring, LOG_HTTP_LINE_RESERVE, &wr);
 
 	va_list ap_copy2;
 	va_copy(ap_copy2, ap);
-	int w = vsnprintf(stack_buf + copy_t, cap - copy_t, fmt, ap_copy2);
+	int w = vsnprintf(dst, wr.cap, fmt, ap_copy2);
 	va_end(ap_copy2);
 
-	if (w < 0) {
-		log_buffer_append_line(stack_buf, strnlen(stack_buf, cap));
-		return ret;
+	/*
+		Не влізло: перший резерв комітимо порожнім (якщо після нас ніхто не резервував, commit
+		віддає його назад повністю, інакше лишається 16-байтний заголовок), і ще раз під точну довжину. Резерв одразу на LOG_HTTP_LINE_MAX
+		при паралельних writer-ах лишав би ~1 КБ арени під короткий рядок.
+	*/
+	if (w > 0 && (size_t)w >= wr.cap && wr.cap < LOG_HTTP_LINE_MAX) {
+		log_ring_commit(&s_ring, &wr, 0, NULL);
+
+		size_t want = (size_t)w + 1;
+		dst = log_ring_reserve(&s_ring, want < LOG_HTTP_LINE_MAX ? want : LOG_HTTP_LINE_MAX, &wr);
+
+		va_copy(ap_copy2, ap);
+		w = vsnprintf(dst, wr.cap, fmt, ap_copy2);
+		va_end(ap_copy2);
 	}
 
-	if ((size_t)w < (cap - copy_t)) {
-		log_buffer_append_line(stack_buf, copy_t + (size_t)w);
-		return ret;
+	size_t len = 0;
+	if (w > 0) {
+		if ((size_t)w < wr.cap) {
+			len = (size_t)w;
+		} else {
+			len = wr.cap - 1;
+			atomic_fetch_add_explicit(&s_ring.truncated, 1, memory_order_relaxed);
+		}
 	}
+	len = trim_eol(dst, len);
 
-	size_t need = copy_t + (size_t)w + 1;
-	if (need > LOG_HTTP_HEAP_MAX) need = LOG_HTTP_HEAP_MAX;
+	log_rec_meta_t meta;
+	log_meta_now(&meta, dst, len);
+	log_ring_commit(&s_ring, &wr, len, &meta);
+	log_wait_kick();
+	return ret;
+}
 
-	char *heap_buf = (char *)malloc(need);
-	if (!heap_buf) {
-		log_buffer_append_line(stack_buf, cap - 1);
-		return ret;
-	}
+/* ----------------- Public API (з mesh RX) ----------------- */
+
+void log_http_server_node_seen(const uint8_t mac[6], const char *tag, uint8_t tag_id)
+{
+	if (!mac) return;
 
-	memcpy(heap_buf, tprefix, copy_t);
-	heap_buf[copy_t] = '\0';
+	bool changed = node_dir_seen(mac, tag, tag_id);
 
-	va_list ap_copy3;
-	va_copy(ap_copy3, ap);
-	vsnprintf(heap_buf + copy_t, need - copy_t, fmt, ap_copy3);
-	va_end(ap_copy3);
+	// last_seen не рахується — інакше /nodes "мінявся" б на кожен пакет
+	if (changed) nodes_changed();
+}
 
-	log_buffer_append_line(heap_buf, strnlen(heap_buf, need));
-	free(heap_buf);
+void log_http_server_node_seen_id(const uint8_t mac[6], uint8_t tag_id)
+{
+	if (!mac) return;
 
-	return ret;
+	bool announce = false;
+	bool changed = node_dir_seen_id(mac, tag_id, &announce);
+
+	if (changed) nodes_changed();
+
+	// стан стріму той самий, що нода вже має — CTRL тут лише за NODEINFO
+	if (announce) mesh_send_log_ctrl(mac, log_sessions_viewers(mac) > 0, MESH_LOG_CTRL_F_ANNOUNCE);
 }
 
-/* ----------------- Public API (з mesh RX) ----------------- */
+// token bucket ноди: зайве відкидаємо до ring-а; нода, що не тримає ліміт, чує про нього знову
+static bool remote_admit(const uint8_t mac[6], size_t len)
+{
+	bool remind = false;
+	if (node_dir_admit_line(mac, (uint32_t)len, &remind)) return true;
 
-void log_http_server_node_seen(const uint8_t mac[6], const char *tag)
+	if (remind) mesh_send_log_ctrl(mac, log_sessions_viewers(mac) > 0, 0);
+	return false;
+}
+
+// кожна нода пише у свій ring; без ring (ніхто не дивиться) — NULL, рядки відкидаємо
+static log_ring_t *remote_ring_acquire(const uint8_t mac[6])
 {
-	if (!mac) return;
+	log_ring_t *r = node_rings_acquire(mac, NULL);
+	if (r) return r;
 
-	portENTER_CRITICAL(&s_nodes_lock);
-	{
-		for (uint32_t i = 0; i < s_nodes_count; i++) {
-			if (mac_eq(s_nodes[i].mac, mac)) {
-				if (tag && tag[0]) {
-					strncpy(s_nodes[i].tag, tag, sizeof(s_nodes[i].tag) - 1);
-					s_nodes[i].tag[sizeof(s_nodes[i].tag) - 1] = '\0';
-				}
-				s_nodes[i].last_seen_ms = ms_now();
-				portEXIT_CRITICAL(&s_nodes_lock);
-				return;
-			}
-		}
+	// ring витіснили під бюджетом, а глядачі лишились — створюємо знову
+	uint16_t viewers = log_sessions_viewers(mac);
+	if (viewers == 0) return NULL;
 
-		if (s_nodes_count < LOG_HTTP_MAX_NODES) {
-			mac_copy(s_nodes[s_nodes_count].mac, mac);
-			strncpy(s_nodes[s_nodes_count].tag, (tag && tag[0]) ? tag : "node", sizeof(s_nodes[s_nodes_count].tag) - 1);
-			s_nodes[s_nodes_count].tag[sizeof(s_nodes[s_nodes_count].tag) - 1] = '\0';
-			s_nodes[s_nodes_count].last_seen_ms = ms_now();
-			s_nodes_count++;
-		}
-	}
-	portEXIT_CRITICAL(&s_nodes_lock);
+	bool created = false;
+	r = node_rings_open(mac, NULL, &created);
+	if (r && created) node_rings_view(mac, viewers);
+	return r;
 }
 
 void log_http_server_remote_line(const uint8_t mac[6], const char *tag, const char *line)
 {
 	if (!mac || !line) return;
-	if (!mac_eq(mac, s_sel_mac)) return;
 
 	(void)tag;
 
-	log_buffer_append_line(line, strnlen(line, 2048));
+	size_t len = strnlen(line, LOG_RING_LINE_MAX);
+	if (!remote_admit(mac, len)) return;
+
+	log_ring_t *r = remote_ring_acquire(mac);
+	if (!r) return;
+
+	log_buffer_append_line(r, line, len);
+	node_rings_release(r);
+
+	log_wait_kick();
+}
+
+// Мітка втрати в ring ноди — перед рядками, що прийшли після дірки
+static void remote_lost_marker(log_ring_t *r, const uint8_t mac[6])
+{
+	uint32_t lost = node_dir_take_lost(mac);
+	if (lost == 0 || !r) return;
+
+	char line[64];
+	int n = snprintf(line, sizeof(line), "W (%lu) root: --- %lu lines lost ---",
+		(unsigned long)ms_now(), (unsigned long)lost);
+	if (n > 0) log_buffer_append_line(r, line, (size_t)n);
+}
+
+// Рядки одного пакета: ring і пробудження читачів — один раз на пакет, не на рядок
+typedef struct {
+	const uint8_t	*mac;
+	log_ring_t	*r;
+	bool		no_ring;	// ніхто не дивиться — решту рядків не пишемо
+	bool		any;
+} remote_batch_t;
+
+static void remote_batch_line(void *ctx, const char *line, size_t len)
+{
+	remote_batch_t *b = (remote_batch_t *)ctx;
+
+	if (b->no_ring || !remote_admit(b->mac, len)) return;
+	if (!b->r) {
+		b->r = remote_ring_acquire(b->mac);
+		if (!b->r) {
+			// ніхто не дивиться — і показувати втрати нікому
+			node_dir_take_lost(b->mac);
+			b->no_ring = true;
+			return;
+		}
+		remote_lost_marker(b->r, b->mac);
+	}
+	log_buffer_append_line(b->r, line, len);
+	b->any = true;
+}
+
+void log_http_server_remote_batch(const uint8_t mac[6], uint32_t seq, uint8_t flags,
+				  const uint8_t *data, size_t len, uint8_t count)
+{
+	if (!mac || !data) return;
+
+	remote_batch_t b = { .mac = mac };
+
+	// дірка в нумерації — рядки, що не дійшли (мережа або черга/ліміт на самій ноді)
+	node_dir_track_seq(mac, seq, count);
+
+	if (flags & MESH_LOG_BATCH_F_DICT) {
+		// історію log_dict розгортаємо навіть без ring — інакше наступна пачка не декодується
+		log_dict_rx_t res = log_dict_rx_batch(mac, seq, (flags & MESH_LOG_BATCH_F_KEY) != 0,
+						      data, len, count, remote_batch_line, &b);
+		if (res != LOG_DICT_RX_OK) node_dir_lost(mac, count);
+
+		// CTRL enable на ноді = почати історію заново; без глядачів — просто вимкнути стрім
+		if (res == LOG_DICT_RX_LOST) mesh_send_log_ctrl(mac, log_sessions_viewers(mac) > 0, 0);
+	} else {
+		size_t off = 0;
+		for (uint8_t i = 0; i < count; i++) {
+			if (off >= len) break;
+			size_t n = data[off++];
+			if (n > len - off) break;	// битий пакет — решту не читаємо
+
+			remote_batch_line(&b, (const char *)data + off, n);
+			off += n;
+		}
+	}
+
+	node_rings_release(b.r);
+	if (b.any) log_wait_kick();
 }
 
 /* ----------------- HTTP handlers ----------------- */
 
-static esp_err_t http_nodes_get(httpd_req_t *req)
+#ifndef NODES_JSON_CHUNK
+	#define NODES_JSON_CHUNK		512	// буфер JSON writer-а (стек); тіло /nodes не обмежене
+#endif
+
+static bool etag_matches(httpd_req_t *req, const char *etag)
+{
+	char inm[64];
+
+	size_t n = httpd_req_get_hdr_value_len(req, "If-None-Match");
+	if (n == 0 || n >= sizeof(inm)) return false;
+	if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) != ESP_OK) return false;
+
+	return strcmp(inm, "*") == 0 || strstr(inm, etag) != NULL;
+}
+
+/*
+	JSON writer шматками: друкує в буфер, повний буфер віддає в sink
+	(chunk HTTP відповіді або фрагмент WebSocket кадру). Розмір тіла не обмежений,
+	стек — тільки NODES_JSON_CHUNK.
+*/
+typedef esp_err_t (*json_sink_t)(void *ctx, const char *data, size_t len, bool last);
+
+typedef struct {
+	json_sink_t	sink;
+	void		*ctx;
+	esp_err_t	err;
+	size_t		len;
+	char		buf[NODES_JSON_CHUNK];
+} json_wr_t;
+
+static void jw_flush(json_wr_t *w, bool last)
+{
+	if (w->err == ESP_OK) w->err = w->sink(w->ctx, w->buf, w->len, last);
+	w->len = 0;
+}
+
+static void jw_printf(json_wr_t *w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void jw_printf(json_wr_t *w, const char *fmt, ...)
+{
+	if (w->err != ESP_OK) return;
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		size_t room = sizeof(w->buf) - w->len;
+
+		va_list ap;
+		va_start(ap, fmt);
+		int n = vsnprintf(w->buf + w->len, room, fmt, ap);
+		va_end(ap);
+
+		if (n < 0) return;
+		if ((size_t)n < room) {
+			w->len += (size_t)n;
+			return;
+		}
+
+		// не влізло — віддаємо що є і пробуємо в порожній буфер
+		if (w->len == 0) break;
+		jw_flush(w, false);
+		if (w->err != ESP_OK) return;
+	}
+
+	// один елемент більший за буфер (не буває з нашими форматами) — обрізаний
+	w->len = sizeof(w->buf) - 1;
+}
+
+static esp_err_t jw_finish(json_wr_t *w)
+{
+	jw_flush(w, true);
+	return w->err;
+}
+
+static esp_err_t http_chunk_sink(void *ctx, const char *data, size_t len, bool last)
+{
+	httpd_req_t *req = (httpd_req_t *)ctx;
+
+	if (len > 0) {
+		esp_err_t err = httpd_resp_send_chunk(req, data, len);
+		if (err != ESP_OK) return err;
+	}
+	return last ? httpd_resp_send_chunk(req, NULL, 0) : ESP_OK;
+}
+
+/*
+	Тіло відповіді з логом: chunk-и як є або через потоковий gzip (log_gzip.h).
+	gzip тільки якщо клієнт його приймає і вільний слот (LOG_HTTP_GZIP_MAX) — інакше як є.
+*/
+typedef struct {
+	httpd_req_t	*req;
+	log_gzip_t	*gz;
+} resp_out_t;
+
+static esp_err_t gzip_chunk_sink(void *ctx, const uint8_t *data, size_t len)
+{
+	return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+static bool accepts_gzip(httpd_req_t *req)
+{
+	char ae[64];
+
+	if (httpd_req_get_hdr_value_len(req, "Accept-Encoding") == 0) return false;
+
+	// довгий заголовок — дивимось на початок (gzip браузери ставлять першим)
+	esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", ae, sizeof(ae));
+	if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) return false;
+	return strstr(ae, "gzip") != NULL;
+}
+
+// Почати gzip (до першого chunk-а). false — слотів/пам'яті нема, тіло піде як є.
+static bool resp_gzip_begin(resp_out_t *o)
+{
+	if (atomic_fetch_add_explicit(&s_gzip_active, 1, memory_order_relaxed) >= LOG_HTTP_GZIP_MAX) {
+		atomic_fetch_sub_explicit(&s_gzip_active, 1, memory_order_relaxed);
+		return false;
+	}
+
+	o->gz = log_gzip_begin(gzip_chunk_sink, o->req);
+	if (!o->gz) {
+		atomic_fetch_sub_explicit(&s_gzip_active, 1, memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+static esp_err_t resp_write(resp_out_t *o, const char *data, size_t len)
+{
+	if (o->gz) return log_gzip_write(o->gz, data, len);
+	return httpd_resp_send_chunk(o->req, data, len);
+}
+
+// Закрити тіло (трейлер gzip + останній chunk); err — помилка, що вже сталась
+static esp_err_t resp_end(resp_out_t *o, esp_err_t err)
+{
+	if (o->gz) {
+		if (err == ESP_OK) err = log_gzip_finish(o->gz);
+		else log_gzip_abort(o->gz);
+		o->gz = NULL;
+		atomic_fetch_sub_explicit(&s_gzip_active, 1, memory_order_relaxed);
+	}
+	if (err != ESP_OK) return err;
+	return httpd_resp_send_chunk(o->req, NULL, 0);
+}
+
+// ноди, що давно мовчать, зникають зі списку (це теж нова версія /nodes)
+static void nodes_expire(void)
+{
+	if (node_dir_expire(NODE_DIR_AGE_MS) > 0) {
+		atomic_fetch_add_explicit(&s_nodes_ver, 1, memory_order_relaxed);
+	}
+}
+
+// ETag = boot id + версія довідника + сесія (у кожної свій selected_mac):
+// після перезавантаження старі ETag не збігаються
+static void nodes_etag(uint32_t sess, char *out, size_t cap)
+{
+	snprintf(out, cap, "\"n%08lx-%lu-%08lx\"", (unsigned long)s_boot_id,
+		(unsigned long)atomic_load_explicit(&s_nodes_ver, memory_order_relaxed), (unsigned long)sess);
+}
+
+// Сесія з cookie запиту (і позначити активною). 0 — без cookie або сесії вже нема (reboot, витіснена).
+static uint32_t req_session(httpd_req_t *req)
 {
-	char out[2048];
-	size_t pos = 0;
+	char v[16];
+	size_t n = sizeof(v);
 
-	pos += snprintf(out + pos, sizeof(out) - pos,
+	log_sessions_expire(LOG_SESSIONS_IDLE_MS);
+
+	if (httpd_req_get_cookie_val(req, LOG_SESSIONS_COOKIE, v, &n) != ESP_OK) return 0;
+
+	uint32_t id = (uint32_t)strtoul(v, NULL, 16);
+	return log_sessions_touch(id) ? id : 0;
+}
+
+// JSON для /nodes і WebSocket push
+static void nodes_json_write(json_wr_t *w, uint32_t sess)
+{
+	uint8_t sel_mac[6];
+	char sel_tag[16];
+	log_sessions_get(sess, sel_mac, sel_tag, sizeof(sel_tag));
+
+	jw_printf(w,
 		"{\"selected_mac\":\"%02x%02x%02x%02x%02x%02x\",\"selected_tag\":\"%s\",\"nodes\":[",
-		s_sel_mac[0], s_sel_mac[1], s_sel_mac[2], s_sel_mac[3], s_sel_mac[4], s_sel_mac[5],
-		s_sel_tag
+		sel_mac[0], sel_mac[1], sel_mac[2], sel_mac[3], sel_mac[4], sel_mac[5],
+		sel_tag
 	);
 
 	// local
-	pos += snprintf(out + pos, sizeof(out) - pos,
+	jw_printf(w,
 		"{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"tag\":\"%s\"}",
 		s_local_mac[0], s_local_mac[1], s_local_mac[2], s_local_mac[3], s_local_mac[4], s_local_mac[5],
 		s_local_tag
 	);
 
-	bool sel_in_list = mac_eq(s_sel_mac, s_local_mac);
+	bool sel_in_list = mac_eq(sel_mac, s_local_mac);
 
-	portENTER_CRITICAL(&s_nodes_lock);
-	{
-		for (uint32_t i = 0; i < s_nodes_count; i++) {
-			if (pos + 128 >= sizeof(out)) break;
+	for (uint32_t i = 0; i < NODE_DIR_MAX && w->err == ESP_OK; i++) {
+		node_dir_ent_t e;
+		if (!node_dir_at(i, &e)) continue;
 
-			// не дублюємо local
-			if (mac_eq(s_nodes[i].mac, s_local_mac)) continue;
+		// не дублюємо local
+		if (mac_eq(e.mac, s_local_mac)) continue;
 
-			if (mac_eq(s_nodes[i].mac, s_sel_mac)) sel_in_list = true;
+		if (mac_eq(e.mac, sel_mac)) sel_in_list = true;
 
-			pos += snprintf(out + pos, sizeof(out) - pos,
-				",{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"tag\":\"%s\"}",
-				s_nodes[i].mac[0], s_nodes[i].mac[1], s_nodes[i].mac[2],
-				s_nodes[i].mac[3], s_nodes[i].mac[4], s_nodes[i].mac[5],
-				s_nodes[i].tag
-			);
-		}
+		jw_printf(w,
+			",{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"tag\":\"%s\"}",
+			e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5],
+			e.tag
+		);
 	}
-	portEXIT_CRITICAL(&s_nodes_lock);
 
 	// якщо вибрана remote нода не в списку — додамо як option (щоб не скидалось)
-	if (!sel_in_list && !mac_eq(s_sel_mac, (uint8_t[6]){0,0,0,0,0,0})) {
-		if (pos + 128 < sizeof(out)) {
-			pos += snprintf(out + pos, sizeof(out) - pos,
-				",{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"tag\":\"%s\"}",
-				s_sel_mac[0], s_sel_mac[1], s_sel_mac[2],
-				s_sel_mac[3], s_sel_mac[4], s_sel_mac[5],
-				s_sel_tag
-			);
-		}
+	if (!sel_in_list && !mac_eq(sel_mac, (uint8_t[6]){0,0,0,0,0,0})) {
+		jw_printf(w,
+			",{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"tag\":\"%s\"}",
+			sel_mac[0], sel_mac[1], sel_mac[2],
+			sel_mac[3], sel_mac[4], sel_mac[5],
+			sel_tag
+		);
 	}
 
-	pos += snprintf(out + pos, sizeof(out) - pos, "]}");
+	jw_printf(w, "]}");
+}
+
+static esp_err_t http_nodes_get(httpd_req_t *req)
+{
+	nodes_expire();
+	uint32_t sess = req_session(req);
+
+	// версія до побудови тіла: якщо список зміниться під час відповіді, наступний poll отримає нове
+	char etag[40];
+	nodes_etag(sess, etag, sizeof(etag));
+
+	httpd_resp_set_hdr(req, "ETag", etag);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+	if (etag_matches(req, etag)) {
+		httpd_resp_set_status(req, "304 Not Modified");
+		return httpd_resp_send(req, NULL, 0);
+	}
 
 	httpd_resp_set_type(req, "application/json");
-	return httpd_resp_send(req, out, HTTPD_RESP_USE_STRLEN);
+
+	json_wr_t w = {
+		.sink	= http_chunk_sink,
+		.ctx	= req,
+		.err	= ESP_OK,
+		.len	= 0,
+	};
+	nodes_json_write(&w, sess);
+	return jw_finish(&w);
 }
 
 static bool parse_mac_hex(const char *s, uint8_t mac[6])
@@ -488,9 +815,17 @@ static bool parse_mac_hex(const char *s, uint8_t mac[6])
 	return true;
 }
 
+/*
+	/select?mac=... — вибір ноди для сесії цього браузера (інші сесії не зачіпає).
+	Без сесії створює нову і ставить cookie; тоді відповідь "NEW" — відкритий WebSocket
+	був без cookie і має перепідключитись.
+*/
 static esp_err_t http_select_get(httpd_req_t *req)
 {
 	char mac_str[64] = {0};
+	uint32_t sess = req_session(req);
+	bool created = false;
+	char cookie[64];
 
 	if (httpd_req_get_url_query_str(req, mac_str, sizeof(mac_str)) == ESP_OK) {
 		char val[32] = {0};
@@ -503,218 +838,1325 @@ static esp_err_t http_select_get(httpd_req_t *req)
 					strncpy(tag, s_local_tag, sizeof(tag) - 1);
 					tag[sizeof(tag) - 1] = '\0';
 				} else {
-					portENTER_CRITICAL(&s_nodes_lock);
-					for (uint32_t i = 0; i < s_nodes_count; i++) {
-						if (mac_eq(s_nodes[i].mac, mac)) {
-							strncpy(tag, s_nodes[i].tag, sizeof(tag) - 1);
-							tag[sizeof(tag) - 1] = '\0';
-							break;
-						}
+					node_dir_ent_t e;
+					if (node_dir_get(mac, &e)) {
+						strncpy(tag, e.tag, sizeof(tag) - 1);
+						tag[sizeof(tag) - 1] = '\0';
 					}
-					portEXIT_CRITICAL(&s_nodes_lock);
 				}
 
-				select_stream_node(mac, tag);
+				sess = log_sessions_select(sess, mac, tag, &created);
+				if (sess == 0) {
+					httpd_resp_set_status(req, "503 Service Unavailable");
+					httpd_resp_set_type(req, "text/plain");
+					return httpd_resp_send(req, "no-session\n", HTTPD_RESP_USE_STRLEN);
+				}
 			}
 		}
 	}
 
+	if (created) {
+		snprintf(cookie, sizeof(cookie), LOG_SESSIONS_COOKIE "=%08lx; Path=/; SameSite=Strict", (unsigned long)sess);
+		httpd_resp_set_hdr(req, "Set-Cookie", cookie);
+	}
+
 	httpd_resp_set_type(req, "text/plain");
-	return httpd_resp_send(req, "OK\n", HTTPD_RESP_USE_STRLEN);
+	return httpd_resp_send(req, created ? "NEW\n" : "OK\n", HTTPD_RESP_USE_STRLEN);
 }
 
 static esp_err_t http_clear_get(httpd_req_t *req)
 {
-	log_buffer_clear();
+	log_buffer_clear(req_session(req));
 	httpd_resp_set_type(req, "text/plain");
 	return httpd_resp_send(req, "OK\n", HTTPD_RESP_USE_STRLEN);
 }
 
-static esp_err_t http_log_get(httpd_req_t *req)
-{
-	// /log?from=123
-	char q[64] = {0};
-	uint32_t from = 0;
+#define STATS_JSON_MAX		1536
 
-	if (httpd_req_get_url_query_str(req, q, sizeof(q)) == ESP_OK) {
-		char v[32] = {0};
-		if (httpd_query_key_value(q, "from", v, sizeof(v)) == ESP_OK) {
-			from = (uint32_t)strtoul(v, NULL, 10);
-		}
+static esp_err_t http_stats_get(httpd_req_t *req)
+{
+	// верхні поля — ring вибраної ноди, rings — всі під бюджетом
+	log_ring_stats_t st;
+	memset(&st, 0, sizeof(st));
+
+	log_ring_t *r = sess_ring_acquire(req_session(req), NULL);
+	if (r) {
+		log_ring_get_stats(r, &st);
+		node_rings_release(r);
 	}
 
-	size_t len = 0;
-	uint32_t next = 0;
-	bool reset = false;
+	log_resp_cache_stats_t cs;
+	log_resp_cache_get_stats(&cs);
 
-	char *snap = log_buffer_snapshot_since(from, &len, &next, &reset);
-	if (!snap) {
+	char *out = (char *)malloc(STATS_JSON_MAX);
+	if (!out) {
 		httpd_resp_set_type(req, "text/plain");
 		return httpd_resp_send(req, "no-mem\n", HTTPD_RESP_USE_STRLEN);
 	}
 
-	char hdr_next[32];
-	snprintf(hdr_next, sizeof(hdr_next), "%lu", (unsigned long)next);
-	httpd_resp_set_hdr(req, "X-Log-Next", hdr_next);
-	httpd_resp_set_hdr(req, "X-Log-Reset", reset ? "1" : "0");
+	size_t pos = snprintf(out, STATS_JSON_MAX,
+		"{\"ring_size\":%lu,\"ring_used\":%lu,\"ring_lines\":%lu,"
+		"\"appends\":%lu,\"truncated\":%lu,\"lapped\":%lu,\"bytes\":%lu,\"deferred\":%lu,\"resets\":%lu,"
+		"\"nodes\":%lu,\"nodes_evicted\":%lu,\"suppressed\":%lu,\"lost\":%lu,\"sessions\":%lu,"
+		"\"cache_hits\":%lu,\"cache_misses\":%lu,\"dict_desync\":%lu,"
+		"\"budget\":%lu,\"allocated\":%lu,\"rings\":[",
+		(unsigned long)st.size, (unsigned long)st.used, (unsigned long)st.lines,
+		(unsigned long)st.appends, (unsigned long)st.truncated, (unsigned long)st.lapped, (unsigned long)st.bytes,
+		(unsigned long)st.deferred, (unsigned long)st.resets,
+		(unsigned long)node_dir_count(), (unsigned long)node_dir_evicted(), (unsigned long)node_dir_suppressed(),
+		(unsigned long)node_dir_lost_total(), (unsigned long)log_sessions_count(),
+		(unsigned long)cs.hits, (unsigned long)cs.misses, (unsigned long)log_dict_rx_desync(),
+		(unsigned long)node_rings_get_budget(), (unsigned long)node_rings_get_allocated()
+	);
 
-	httpd_resp_set_type(req, "text/plain");
-	esp_err_t err = httpd_resp_send(req, snap, len);
-	free(snap);
+	bool first = true;
+	for (uint32_t i = 0; i < NODE_RINGS_MAX; i++) {
+		node_ring_info_t ri;
+		if (!node_rings_get_info(i, &ri)) continue;
+		if (pos + 192 >= STATS_JSON_MAX) break;
+
+		pos += snprintf(out + pos, STATS_JSON_MAX - pos,
+			"%s{\"mac\":\"%02x%02x%02x%02x%02x%02x\",\"gen\":%lu,\"size\":%lu,\"used\":%lu,"
+			"\"appends\":%lu,\"viewers\":%u,\"pinned\":%s,\"idle_ms\":%lu}",
+			first ? "" : ",",
+			ri.mac[0], ri.mac[1], ri.mac[2], ri.mac[3], ri.mac[4], ri.mac[5],
+			(unsigned long)ri.gen, (unsigned long)ri.size, (unsigned long)ri.used,
+			(unsigned long)ri.appends, (unsigned)ri.viewers, ri.pinned ? "true" : "false",
+			(unsigned long)ri.idle_ms
+		);
+		first = false;
+	}
+	pos += snprintf(out + pos, STATS_JSON_MAX - pos, "]");
+
+	if (log_flash_ready()) {
+		log_flash_stats_t fs;
+		log_flash_get_stats(&fs);
+		pos += snprintf(out + pos, STATS_JSON_MAX - pos,
+			",\"flash\":{\"size\":%lu,\"sectors\":%lu,\"oldest\":%lu,\"next\":%lu,\"oldest_ts\":%lu,"
+			"\"records\":%lu,\"dropped\":%lu,\"erases\":%lu,\"max_erase\":%lu}",
+			(unsigned long)fs.size, (unsigned long)fs.sectors, (unsigned long)fs.oldest, (unsigned long)fs.next,
+			(unsigned long)fs.oldest_ts, (unsigned long)fs.records, (unsigned long)fs.dropped,
+			(unsigned long)fs.erases, (unsigned long)fs.max_erase
+		);
+	}
+	pos += snprintf(out + pos, STATS_JSON_MAX - pos, "}");
+
+	httpd_resp_set_type(req, "application/json");
+	esp_err_t err = httpd_resp_send(req, out, pos);
+	free(out);
 	return err;
 }
 
-static esp_err_t http_root_get(httpd_req_t *req)
+static esp_err_t http_budget_get(httpd_req_t *req)
 {
-	static const char html[] =
-		"<!doctype html>\n"
-		"<html><head><meta charset='utf-8'>\n"
-		"<meta name='viewport' content='width=device-width, initial-scale=1'>\n"
-		"<title>keeMASH logs</title>\n"
-		"<style>\n"
-		"body{font-family:monospace;background:#111;color:#ddd;margin:0;padding:0}\n"
-		"#top{padding:10px;background:#1b1b1b;position:sticky;top:0;display:flex;gap:10px;align-items:center}\n"
-		"#log{overflow:auto;height:calc(100vh - 60px);padding:10px;white-space:pre}\n"
-		".ln{white-space:pre;margin:0;padding:0}\n"
-		"button,select{font-family:monospace;font-size:14px}\n"
-		".lvI{color:#00ff7f}\n"
-		".lvW{color:#ffcc00}\n"
-		".lvE{color:#ff4d4d}\n"
-		".lvD{color:#66a3ff}\n"
-		".lvV{color:#aaaaaa}\n"
-		".ts{color:#66a3ff}\n"
-		"</style></head>\n"
-		"<body>\n"
-		"<div id='top'>\n"
-		"<button onclick='toggleFollow()'>follow: <span id=\"f\">ON</span></button>\n"
-		"<button onclick='clearServer()'>clear</button>\n"
-		"<select id='nodeSel'></select>\n"
-		"<span id='st'>...</span>\n"
-		"</div>\n"
-		"<div id='log'></div>\n"
-		"<script>\n"
-		"let follow=true;\n"
-		"let cursor=0;\n"
-		"let lastNodes='';\n"
-		"function toggleFollow(){follow=!follow;document.getElementById('f').textContent=follow?'ON':'OFF'}\n"
-		"function esc(s){return s.replaceAll('&','&amp;').replaceAll('<','&lt;').replaceAll('>','&gt;')}\n"
-		"function lvlClassByRest(rest){\n"
-		"  if(!rest||rest.length===0) return '';\n"
-		"  const c=rest[0];\n"
-		"  if(c==='I') return 'lvI';\n"
-		"  if(c==='W') return 'lvW';\n"
-		"  if(c==='E') return 'lvE';\n"
-		"  if(c==='D') return 'lvD';\n"
-		"  if(c==='V') return 'lvV';\n"
-		"  return '';\n"
-		"}\n"
-		"function renderChunk(text){\n"
-		"  const lines=text.split('\\n');\n"
-		"  let out='';\n"
-		"  for(let raw of lines){\n"
-		"    if(raw===undefined||raw===null) continue;\n"
-		"    raw=raw.replace(/\\r/g,'');\n"
-		"    if(raw.trim().length===0) continue; // <-- прибирає фейкові пусті рядки\n"
-		"\n"
-		"    let ts='';\n"
-		"    let rest=raw;\n"
-		"    if(raw[0]==='['){\n"
-		"      const k=raw.indexOf(']');\n"
-		"      if(k>0 && k<40){\n"
-		"        ts=raw.slice(0,k+1);\n"
-		"        rest=raw.slice(k+1).trimStart();\n"
-		"      }\n"
-		"    }\n"
-		"\n"
-		"    const cls=lvlClassByRest(rest);\n"
-		"    if(ts){\n"
-		"      out+=`<div class=\"ln ${cls}\"><span class=\"ts\">${esc(ts)}</span> ${esc(rest)}</div>`;\n"
-		"    }else{\n"
-		"      out+=`<div class=\"ln ${cls}\">${esc(rest)}</div>`;\n"
-		"    }\n"
-		"  }\n"
-		"  return out;\n"
-		"}\n"
-		"async function tick(){\n"
-		"  try{\n"
-		"    const r=await fetch('/log?from='+cursor);\n"
-		"    const next=r.headers.get('X-Log-Next');\n"
-		"    const reset=r.headers.get('X-Log-Reset');\n"
-		"    const t=await r.text();\n"
-		"    const el=document.getElementById('log');\n"
-		"    if(reset==='1') el.innerHTML='';\n"
-		"    if(t && t.length>0) el.insertAdjacentHTML('beforeend', renderChunk(t));\n"
-		"    if(next) cursor=parseInt(next);\n"
-		"    if(follow) el.scrollTop=el.scrollHeight;\n"
-		"    document.getElementById('st').textContent='OK';\n"
-		"  }catch(e){document.getElementById('st').textContent='ERR'}\n"
-		"}\n"
-		"async function loadNodes(){\n"
-		"  const s=document.getElementById('nodeSel');\n"
-		"  if(document.activeElement===s) return;\n"
-		"  try{\n"
-		"    const r=await fetch('/nodes');\n"
-		"    const txt=await r.text();\n"
-		"    if(txt===lastNodes) return;\n"
-		"    lastNodes=txt;\n"
-		"    const j=JSON.parse(txt);\n"
-		"    const cur=j.selected_mac;\n"
-		"    const prev=s.value;\n"
-		"    s.innerHTML='';\n"
-		"    for(const n of j.nodes){\n"
-		"      const o=document.createElement('option');\n"
-		"      o.value=n.mac;\n"
-		"      o.textContent=n.tag+' ['+n.mac+']';\n"
-		"      s.appendChild(o);\n"
-		"    }\n"
-		"    s.value = cur || prev;\n"
-		"  }catch(e){}\n"
-		"}\n"
-		"async function onNodeSel(){\n"
-		"  const s=document.getElementById('nodeSel');\n"
-		"  const mac=s.value;\n"
-		"  cursor=0;\n"
-		"  document.getElementById('log').innerHTML='';\n"
-		"  try{await fetch('/select?mac='+mac);}catch(e){}\n"
-		"}\n"
-		"async function clearServer(){\n"
-		"  cursor=0;\n"
-		"  try{await fetch('/clear');}catch(e){}\n"
-		"  document.getElementById('log').innerHTML='';\n"
-		"}\n"
-		"document.getElementById('nodeSel').addEventListener('change',(e)=>{\n"
-		"  if(!e.isTrusted) return;\n"
-		"  onNodeSel();\n"
-		"});\n"
-		"setInterval(tick," STR(WEB_POLL_MS) ");\n"
-		"setInterval(loadNodes,2000);\n"
-		"loadNodes();\n"
-		"tick();\n"
-		"</script>\n"
-		"</body></html>\n";
+	// /budget?bytes=65536 — змінити загальний бюджет ring-ів (зайві витісняються одразу)
+	char q[64] = {0};
 
-	httpd_resp_set_type(req, "text/html");
-	return httpd_resp_send(req, html, HTTPD_RESP_USE_STRLEN);
-}
+	if (httpd_req_get_url_query_str(req, q, sizeof(q)) == ESP_OK) {
+		char v[32] = {0};
+		if (httpd_query_key_value(q, "bytes", v, sizeof(v)) == ESP_OK) {
+			uint32_t bytes = (uint32_t)strtoul(v, NULL, 10);
+			if (bytes < LOG_HTTP_RING_BYTES) bytes = LOG_HTTP_RING_BYTES;	// local ring не витісняється
+			node_rings_set_budget(bytes);
+			log_wait_kick();
+		}
+	}
 
+	char out[96];
+	snprintf(out, sizeof(out), "{\"budget\":%lu,\"allocated\":%lu}",
+		(unsigned long)node_rings_get_budget(), (unsigned long)node_rings_get_allocated());
 
-/* ----------------- Public API ----------------- */
+	httpd_resp_set_type(req, "application/json");
+	return httpd_resp_send(req, out, HTTPD_RESP_USE_STRLEN);
+}
 
-esp_err_t log_http_server_init(void)
+/*
+	/log/history — local лог з flash (log_flash.h), старший за RAM ring і після reboot.
+	?from=<cursor> або ?since=<unix ts>, &until=<unix ts>, &fmt=bin — як /log;
+	X-Log-Next — звідки питати далі, порожня відповідь — дійшли до кінця записаного.
+*/
+static esp_err_t http_log_history_get(httpd_req_t *req)
 {
-	esp_wifi_get_mac(WIFI_IF_STA, s_local_mac);
+	if (!log_flash_ready()) {
+		httpd_resp_set_status(req, "404 Not Found");
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_send(req, "no '" LOG_FLASH_LABEL "' partition\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	char qs[96] = {0};
+	char v[16];
+	uint32_t cursor = 0;
+	uint32_t until = 0;
+	log_ring_fmt_t fmt = LOG_RING_FMT_TEXT;
+
+	if (httpd_req_get_url_query_str(req, qs, sizeof(qs)) == ESP_OK) {
+		if (httpd_query_key_value(qs, "from", v, sizeof(v)) == ESP_OK) {
+			cursor = (uint32_t)strtoul(v, NULL, 10);
+		} else if (httpd_query_key_value(qs, "since", v, sizeof(v)) == ESP_OK) {
+			cursor = log_flash_find_time((uint32_t)strtoul(v, NULL, 10));
+		}
+		if (httpd_query_key_value(qs, "until", v, sizeof(v)) == ESP_OK) {
+			until = (uint32_t)strtoul(v, NULL, 10);
+		}
+		if (httpd_query_key_value(qs, "fmt", v, sizeof(v)) == ESP_OK && strcmp(v, "bin") == 0) {
+			fmt = LOG_RING_FMT_BIN;
+		}
+	}
+
+	char *chunk = (char *)malloc(LOG_HTTP_CHUNK);
+	if (!chunk) {
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_send(req, "no-mem\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	bool reset = false;
+	uint32_t next = log_flash_frontier(&cursor, until, LOG_HTTP_HISTORY_MAX, &reset);
+
+	char hdr_next[16];
+	snprintf(hdr_next, sizeof(hdr_next), "%lu", (unsigned long)next);
+	httpd_resp_set_type(req, (fmt == LOG_RING_FMT_BIN) ? "application/octet-stream" : "text/plain");
+	httpd_resp_set_hdr(req, "X-Log-Next", hdr_next);
+	httpd_resp_set_hdr(req, "X-Log-Reset", reset ? "1" : "0");
+	httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+	esp_err_t err = ESP_OK;
+	while ((int32_t)(next - cursor) > 0) {
+		uint32_t before = cursor;
+		size_t n = log_flash_read(&cursor, next, chunk, LOG_HTTP_CHUNK, fmt);
+
+		if (n > 0) {
+			err = httpd_resp_send_chunk(req, chunk, n);
+			if (err != ESP_OK) break;
+		}
+		// сектор стерли посеред відповіді — клієнт продовжить з X-Log-Next
+		if (cursor == before) break;
+	}
+
+	free(chunk);
+	if (err != ESP_OK) return err;
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/*
+	/metrics — лічильники root у Prometheus text format (0.0.4), для локального scraper-а.
+	*_total — монотонні з boot (rate() рахує scraper), решта — gauge на момент запиту.
+	Тіло chunked через той самий writer, що й /nodes.
+*/
+
+#ifndef METRICS_TASKS_MAX
+	#define METRICS_TASKS_MAX		24
+#endif
+
+static void metric_head(json_wr_t *w, const char *name, const char *type, const char *help)
+{
+	jw_printf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// значення label: \ " і перевід рядка екрануються
+static void metric_label_esc(const char *s, char *out, size_t cap)
+{
+	size_t o = 0;
+
+	for (; *s && o + 2 < cap; s++) {
+		if (*s == '\\' || *s == '"') {
+			out[o++] = '\\';
+			out[o++] = *s;
+		} else if (*s == '\n') {
+			out[o++] = '\\';
+			out[o++] = 'n';
+		} else {
+			out[o++] = *s;
+		}
+	}
+	out[o] = '\0';
+}
+
+static const char *pkt_type_name(uint32_t i)
+{
+	if (i == ROOT_METRICS_TYPES - 1) return "other";
+
+	switch (i) {
+	case MESH_PKT_TYPE_TEXT:		return "text";
+	case MESH_TIME_SYNC_TYPE_TIME:		return "time";
+	case MESH_LOG_TYPE_LINE:		return "log_line";
+	case MESH_LOG_TYPE_NODEINFO:		return "nodeinfo";
+	case MESH_LOG_TYPE_CTRL:		return "ctrl";
+	case MESH_LOG_TYPE_BATCH:		return "log_batch";
+	default:				return NULL;
+	}
+}
+
+static void metrics_write(json_wr_t *w)
+{
+	root_metrics_t m;
+	root_metrics_get(&m);
+
+	// mesh RX
+	metric_head(w, "mesh_rx_packets_total", "counter", "Packets of our protocol received by type");
+	for (uint32_t i = 0; i < ROOT_METRICS_TYPES; i++) {
+		const char *name = pkt_type_name(i);
+		if (name) jw_printf(w, "mesh_rx_packets_total{type=\"%s\"} %lu\n", name, (unsigned long)m.rx_pkts[i]);
+		else jw_printf(w, "mesh_rx_packets_total{type=\"%lu\"} %lu\n", (unsigned long)i, (unsigned long)m.rx_pkts[i]);
+	}
+	metric_head(w, "mesh_rx_bytes_total", "counter", "Bytes of our protocol received by type");
+	for (uint32_t i = 0; i < ROOT_METRICS_TYPES; i++) {
+		const char *name = pkt_type_name(i);
+		if (name) jw_printf(w, "mesh_rx_bytes_total{type=\"%s\"} %lu\n", name, (unsigned long)m.rx_bytes[i]);
+		else jw_printf(w, "mesh_rx_bytes_total{type=\"%lu\"} %lu\n", (unsigned long)i, (unsigned long)m.rx_bytes[i]);
+	}
+	metric_head(w, "mesh_rx_dropped_total", "counter", "Packets dropped in mesh_rx_task");
+	jw_printf(w,
+		"mesh_rx_dropped_total{reason=\"short\"} %lu\n"
+		"mesh_rx_dropped_total{reason=\"unknown\"} %lu\n"
+		"mesh_rx_dropped_total{reason=\"recv_error\"} %lu\n",
+		(unsigned long)m.rx_short, (unsigned long)m.rx_unknown, (unsigned long)m.rx_errors
+	);
+
+	// root -> ноди
+	metric_head(w, "mesh_bcast_sends_total", "counter", "Per-node sends of root broadcasts by result");
+	jw_printf(w,
+		"mesh_bcast_sends_total{result=\"ok\"} %lu\n"
+		"mesh_bcast_sends_total{result=\"failed\"} %lu\n",
+		(unsigned long)m.bcast_sent, (unsigned long)m.bcast_failed
+	);
+
+	// UART bridge
+	metric_head(w, "uart_lines_total", "counter", "Lines through the UART bridge by direction");
+	jw_printf(w,
+		"uart_lines_total{dir=\"in\"} %lu\n"
+		"uart_lines_total{dir=\"out\"} %lu\n",
+		(unsigned long)m.uart_in, (unsigned long)m.uart_out
+	);
+	metric_head(w, "uart_overflow_total", "counter", "UART input lines longer than the bridge buffer");
+	jw_printf(w, "uart_overflow_total %lu\n", (unsigned long)m.uart_overflow);
+
+	// vprintf hook: у local ring без heap; не відкладені рядки форматуються одразу в арену
+	metric_head(w, "log_hook_lines_total", "counter", "Local log lines by how the hook stored them");
+	jw_printf(w,
+		"log_hook_lines_total{mode=\"deferred\"} %lu\n"
+		"log_hook_lines_total{mode=\"formatted\"} %lu\n",
+		(unsigned long)atomic_load_explicit(&s_ring.deferred, memory_order_relaxed),
+		(unsigned long)(atomic_load_explicit(&s_ring.appends, memory_order_relaxed) -
+			atomic_load_explicit(&s_ring.deferred, memory_order_relaxed))
+	);
+	metric_head(w, "log_hook_truncated_total", "counter", "Local log lines cut to LOG_HTTP_LINE_MAX");
+	jw_printf(w, "log_hook_truncated_total %lu\n",
+		(unsigned long)atomic_load_explicit(&s_ring.truncated, memory_order_relaxed));
+	metric_head(w, "log_hook_lapped_total", "counter", "Local log lines dropped because the ring lapped the writer before commit");
+	jw_printf(w, "log_hook_lapped_total %lu\n",
+		(unsigned long)atomic_load_explicit(&s_ring.lapped, memory_order_relaxed));
+
+	// ring-и (local + remote під бюджетом)
+	metric_head(w, "log_ring_appends_total", "counter", "Records appended to a log ring");
+	for (uint32_t i = 0; i < NODE_RINGS_MAX && w->err == ESP_OK; i++) {
+		node_ring_info_t ri;
+		if (!node_rings_get_info(i, &ri)) continue;
+		jw_printf(w, "log_ring_appends_total{mac=\"%02x%02x%02x%02x%02x%02x\"} %lu\n",
+			ri.mac[0], ri.mac[1], ri.mac[2], ri.mac[3], ri.mac[4], ri.mac[5], (unsigned long)ri.appends);
+	}
+	metric_head(w, "log_ring_resets_total", "counter", "Readers reset because the ring overtook them or was cleared");
+	for (uint32_t i = 0; i < NODE_RINGS_MAX && w->err == ESP_OK; i++) {
+		node_ring_info_t ri;
+		if (!node_rings_get_info(i, &ri)) continue;
+		jw_printf(w, "log_ring_resets_total{mac=\"%02x%02x%02x%02x%02x%02x\"} %lu\n",
+			ri.mac[0], ri.mac[1], ri.mac[2], ri.mac[3], ri.mac[4], ri.mac[5], (unsigned long)ri.resets);
+	}
+	metric_head(w, "log_ring_used_bytes", "gauge", "Bytes currently held by a log ring");
+	for (uint32_t i = 0; i < NODE_RINGS_MAX && w->err == ESP_OK; i++) {
+		node_ring_info_t ri;
+		if (!node_rings_get_info(i, &ri)) continue;
+		jw_printf(w, "log_ring_used_bytes{mac=\"%02x%02x%02x%02x%02x%02x\"} %lu\n",
+			ri.mac[0], ri.mac[1], ri.mac[2], ri.mac[3], ri.mac[4], ri.mac[5], (unsigned long)ri.used);
+	}
+	metric_head(w, "log_ring_budget_bytes", "gauge", "Total ring budget and allocated bytes");
+	jw_printf(w,
+		"log_ring_budget_bytes{kind=\"budget\"} %lu\n"
+		"log_ring_budget_bytes{kind=\"allocated\"} %lu\n",
+		(unsigned long)node_rings_get_budget(), (unsigned long)node_rings_get_allocated()
+	);
+
+	// ноди з довідника
+	metric_head(w, "node_log_lines_total", "counter", "Log lines received from a node");
+	for (uint32_t i = 0; i < NODE_DIR_MAX && w->err == ESP_OK; i++) {
+		node_dir_ent_t e;
+		if (!node_dir_at(i, &e)) continue;
+		char tag[2 * sizeof(e.tag)];
+		metric_label_esc(e.tag, tag, sizeof(tag));
+		jw_printf(w, "node_log_lines_total{mac=\"%02x%02x%02x%02x%02x%02x\",tag=\"%s\"} %lu\n",
+			e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5], tag, (unsigned long)e.lines);
+	}
+	metric_head(w, "node_log_bytes_total", "counter", "Log text bytes received from a node");
+	for (uint32_t i = 0; i < NODE_DIR_MAX && w->err == ESP_OK; i++) {
+		node_dir_ent_t e;
+		if (!node_dir_at(i, &e)) continue;
+		char tag[2 * sizeof(e.tag)];
+		metric_label_esc(e.tag, tag, sizeof(tag));
+		jw_printf(w, "node_log_bytes_total{mac=\"%02x%02x%02x%02x%02x%02x\",tag=\"%s\"} %lu\n",
+			e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5], tag, (unsigned long)e.bytes);
+	}
+	metric_head(w, "node_log_suppressed_total", "counter", "Log lines from a node dropped by the root rate limit");
+	for (uint32_t i = 0; i < NODE_DIR_MAX && w->err == ESP_OK; i++) {
+		node_dir_ent_t e;
+		if (!node_dir_at(i, &e)) continue;
+		char tag[2 * sizeof(e.tag)];
+		metric_label_esc(e.tag, tag, sizeof(tag));
+		jw_printf(w, "node_log_suppressed_total{mac=\"%02x%02x%02x%02x%02x%02x\",tag=\"%s\"} %lu\n",
+			e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5], tag, (unsigned long)e.suppressed);
+	}
+	metric_head(w, "node_log_lost_total", "counter", "Log lines from a node that never reached the ring (sequence gaps, undecodable batches)");
+	for (uint32_t i = 0; i < NODE_DIR_MAX && w->err == ESP_OK; i++) {
+		node_dir_ent_t e;
+		if (!node_dir_at(i, &e)) continue;
+		char tag[2 * sizeof(e.tag)];
+		metric_label_esc(e.tag, tag, sizeof(tag));
+		jw_printf(w, "node_log_lost_total{mac=\"%02x%02x%02x%02x%02x%02x\",tag=\"%s\"} %lu\n",
+			e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5], tag, (unsigned long)e.lost);
+	}
+	metric_head(w, "node_log_dict_desync_total", "counter", "Compressed log batches dropped until the next keyframe");
+	jw_printf(w, "node_log_dict_desync_total %lu\n", (unsigned long)log_dict_rx_desync());
+	metric_head(w, "node_dir_nodes", "gauge", "Nodes in the directory");
+	jw_printf(w, "node_dir_nodes %lu\n", (unsigned long)node_dir_count());
+	metric_head(w, "log_http_sessions", "gauge", "Dashboard sessions with their own node selection");
+	jw_printf(w, "log_http_sessions %lu\n", (unsigned long)log_sessions_count());
+
+	// клієнти
+	metric_head(w, "log_http_clients", "gauge", "Open dashboard connections by kind");
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+	jw_printf(w, "log_http_clients{kind=\"ws\"} %lu\n",
+		(unsigned long)atomic_load_explicit(&s_ws_count, memory_order_relaxed));
+#else
+	jw_printf(w, "log_http_clients{kind=\"ws\"} 0\n");
+#endif
+	jw_printf(w, "log_http_clients{kind=\"long_poll\"} %lu\n",
+		(unsigned long)atomic_load_explicit(&s_wait_parked, memory_order_relaxed));
+
+	log_resp_cache_stats_t cs;
+	log_resp_cache_get_stats(&cs);
+	metric_head(w, "log_http_cache_total", "counter", "Rendered /log and /ws chunks by response cache outcome");
+	jw_printf(w,
+		"log_http_cache_total{result=\"hit\"} %lu\n"
+		"log_http_cache_total{result=\"miss\"} %lu\n",
+		(unsigned long)cs.hits, (unsigned long)cs.misses
+	);
+
+	// flash історія
+	if (log_flash_ready()) {
+		log_flash_stats_t fs;
+		log_flash_get_stats(&fs);
+		metric_head(w, "log_flash_records_total", "counter", "Records written to the flash history");
+		jw_printf(w, "log_flash_records_total %lu\n", (unsigned long)fs.records);
+		metric_head(w, "log_flash_dropped_total", "counter", "Gaps in the flash history");
+		jw_printf(w, "log_flash_dropped_total %lu\n", (unsigned long)fs.dropped);
+		metric_head(w, "log_flash_erases_total", "counter", "Flash sector erases");
+		jw_printf(w, "log_flash_erases_total %lu\n", (unsigned long)fs.erases);
+	}
+
+	// таски (live знімок; CPU % — за останній період stack_monitor)
+	stack_monitor_task_t *tasks = (stack_monitor_task_t *)malloc(METRICS_TASKS_MAX * sizeof(*tasks));
+	if (tasks) {
+		uint32_t total = 0;
+		size_t n = stack_monitor_snapshot(tasks, METRICS_TASKS_MAX, &total);
+
+		metric_head(w, "task_stack_free_bytes", "gauge", "Minimum free stack ever seen for a task");
+		for (size_t i = 0; i < n; i++) {
+			char name[2 * sizeof(tasks[i].name)];
+			metric_label_esc(tasks[i].name, name, sizeof(name));
+			jw_printf(w, "task_stack_free_bytes{task=\"%s\"} %lu\n", name, (unsigned long)tasks[i].stack_free);
+		}
+		metric_head(w, "task_run_time_total", "counter", "FreeRTOS run time counter of a task (wraps)");
+		for (size_t i = 0; i < n; i++) {
+			char name[2 * sizeof(tasks[i].name)];
+			metric_label_esc(tasks[i].name, name, sizeof(name));
+			jw_printf(w, "task_run_time_total{task=\"%s\"} %lu\n", name, (unsigned long)tasks[i].run_time);
+		}
+		metric_head(w, "task_cpu_percent", "gauge", "CPU share of a task over the last stack monitor period");
+		for (size_t i = 0; i < n; i++) {
+			char name[2 * sizeof(tasks[i].name)];
+			metric_label_esc(tasks[i].name, name, sizeof(name));
+			jw_printf(w, "task_cpu_percent{task=\"%s\"} %u.%u\n", name,
+				(unsigned)(tasks[i].cpu_x10 / 10), (unsigned)(tasks[i].cpu_x10 % 10));
+		}
+		metric_head(w, "task_priority", "gauge", "Current FreeRTOS priority of a task");
+		for (size_t i = 0; i < n; i++) {
+			char name[2 * sizeof(tasks[i].name)];
+			metric_label_esc(tasks[i].name, name, sizeof(name));
+			jw_printf(w, "task_priority{task=\"%s\"} %u\n", name, (unsigned)tasks[i].prio);
+		}
+		free(tasks);
+
+		uint16_t load = stack_monitor_cpu_load_x10();
+		metric_head(w, "cpu_load_percent", "gauge", "CPU load without idle over the last stack monitor period");
+		jw_printf(w, "cpu_load_percent %u.%u\n", (unsigned)(load / 10), (unsigned)(load % 10));
+	}
+
+	metric_head(w, "heap_free_bytes", "gauge", "Free heap now and the minimum since boot");
+	jw_printf(w,
+		"heap_free_bytes{kind=\"now\"} %lu\n"
+		"heap_free_bytes{kind=\"min\"} %lu\n",
+		(unsigned long)esp_get_free_heap_size(), (unsigned long)esp_get_minimum_free_heap_size()
+	);
+}
+
+static esp_err_t http_metrics_get(httpd_req_t *req)
+{
+	httpd_resp_set_type(req, "text/plain; version=0.0.4");
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+	json_wr_t w = {
+		.sink	= http_chunk_sink,
+		.ctx	= req,
+		.err	= ESP_OK,
+		.len	= 0,
+	};
+	metrics_write(&w);
+	return jw_finish(&w);
+}
+
+// %XX і '+' у значенні query (httpd_query_key_value віддає як є), на місці
+static size_t url_decode(char *s)
+{
+	char *o = s;
+
+	for (const char *p = s; *p; p++) {
+		if (*p == '+') {
+			*o++ = ' ';
+		} else if (*p == '%' && isxdigit((unsigned char)p[1]) && isxdigit((unsigned char)p[2])) {
+			char hex[3] = { p[1], p[2], 0 };
+			*o++ = (char)strtoul(hex, NULL, 16);
+			p += 2;
+		} else {
+			*o++ = *p;
+		}
+	}
+	*o = '\0';
+	return (size_t)(o - s);
+}
+
+/*
+	/log і /ws: from, ring, fmt=bin (бінарні записи замість тексту), node=<mac>,
+	фільтри: level=E|W|I|D|V (цей і важливіші), tag=<tag>, q=<підрядок>
+*/
+static void log_query_parse(const char *qs, log_query_t *q)
+{
+	char v[3 * LOG_RING_FIND_MAX + 1] = {0};
+
+	if (httpd_query_key_value(qs, "from", v, sizeof(v)) == ESP_OK) {
+		q->cursor = (uint32_t)strtoul(v, NULL, 10);
+	}
+	if (httpd_query_key_value(qs, "ring", v, sizeof(v)) == ESP_OK) {
+		q->ring = (uint32_t)strtoul(v, NULL, 10);
+	}
+	if (httpd_query_key_value(qs, "fmt", v, sizeof(v)) == ESP_OK) {
+		q->fmt = (strcmp(v, "bin") == 0) ? LOG_RING_FMT_BIN : LOG_RING_FMT_TEXT;
+	}
+	if (httpd_query_key_value(qs, "node", v, sizeof(v)) == ESP_OK) {
+		q->has_node = parse_mac_hex(v, q->node);
+	}
+	if (httpd_query_key_value(qs, "level", v, sizeof(v)) == ESP_OK) {
+		q->flt.max_level = log_ring_level_of(v[0]);
+	}
+	if (httpd_query_key_value(qs, "tag", v, sizeof(v)) == ESP_OK) {
+		size_t n = url_decode(v);
+		if (n < sizeof(q->flt.tag)) {
+			memcpy(q->flt.tag, v, n);
+			q->flt.tag_len = (uint8_t)n;
+		}
+	}
+	if (httpd_query_key_value(qs, "q", v, sizeof(v)) == ESP_OK) {
+		size_t n = url_decode(v);
+		if (n > sizeof(q->flt.find)) n = sizeof(q->flt.find);
+		memcpy(q->flt.find, v, n);
+		q->flt.find_len = (uint8_t)n;
+	}
+}
+
+// Ring, який читає запит (refs++): node= або вибраний сесією
+static log_ring_t *query_ring_acquire(const log_query_t *q, uint32_t *gen)
+{
+	if (q->has_node) return node_rings_acquire(q->node, gen);
+	return sess_ring_acquire(q->sess, gen);
+}
+
+/*
+	Один шматок [*cursor, next) у out (cap = LOG_HTTP_CHUNK): з кешу відповідей, якщо його вже
+	рендерили для іншого клієнта, інакше з ring — і в кеш, якщо весь діапазон вліз цілим.
+*/
+static size_t ring_read_cached(log_ring_t *r, uint32_t gen, uint32_t *cursor, uint32_t next,
+			       char *out, bool *lost, const log_query_t *q)
+{
+	log_resp_key_t k = { .gen = gen, .from = *cursor, .to = next, .fmt = q->fmt, .flt = &q->flt };
+	size_t n = 0;
+
+	*lost = false;
+	if (log_resp_cache_get(&k, out, LOG_HTTP_CHUNK, &n)) {
+		*cursor = next;
+		return n;
+	}
+
+	n = log_ring_read_fmt(r, cursor, next, out, LOG_HTTP_CHUNK, lost, q->fmt, &q->flt);
+	if (!*lost && *cursor == next) log_resp_cache_put(&k, out, n);
+	return n;
+}
+
+/*
+	Мітка дірки прямо у відповіді (TEXT — рядок, BIN — запис з cursor pos, де почалась дірка).
+	X-Log-Next вже відправлений і лишається валідним — reset клієнт не отримає, тож інакше
+	переписані посеред відповіді рядки просто зникли б. out >= LOG_HTTP_LOST_MAX.
+*/
+#define LOG_HTTP_LOST_MAX	(LOG_RING_TEXT_PREFIX_MAX + 80 + 1)
+
+static size_t resp_lost_marker(log_ring_fmt_t fmt, uint32_t pos, char *out)
+{
+	char line[80];
+	int n = snprintf(line, sizeof(line), "W (%lu) log_http: --- reader overtaken, lines lost ---",
+		(unsigned long)ms_now());
+	if (n <= 0 || (size_t)n >= sizeof(line)) return 0;
+
+	log_rec_meta_t m;
+	log_meta_now(&m, line, (size_t)n);
+
+	size_t pre = log_ring_fmt_prefix(fmt, pos, &m, (size_t)n, out);
+	memcpy(out + pre, line, (size_t)n);
+	pre += (size_t)n;
+	if (fmt == LOG_RING_FMT_TEXT) out[pre++] = '\n';
+	return pre;
+}
+
+// Віддати все нове після q->cursor (шматками, chunked). Працює і на async копії запиту.
+static esp_err_t log_send_since(httpd_req_t *req, const log_query_t *q)
+{
+	uint32_t gen = 0;
+	log_ring_t *r = query_ring_acquire(q, &gen);
+
+	httpd_resp_set_type(req, (q->fmt == LOG_RING_FMT_BIN) ? "application/octet-stream" : "text/plain");
+
+	if (!r) {
+		// ring ще не створений / витіснений — порожньо, клієнт почне з нуля
+		httpd_resp_set_hdr(req, "X-Log-Next", "0");
+		httpd_resp_set_hdr(req, "X-Log-Reset", "1");
+		httpd_resp_set_hdr(req, "X-Log-Ring", "0");
+		return httpd_resp_send(req, NULL, 0);
+	}
+
+	char *chunk = (char *)malloc(LOG_HTTP_CHUNK);
+	if (!chunk) {
+		node_rings_release(r);
+		return httpd_resp_send(req, "no-mem\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	// 1) межа того, що віддамо цим запитом (потрібна до заголовків)
+	bool reset = false;
+	uint32_t cursor = cursor_for(q->ring, gen, q->cursor);
+	uint32_t next = log_ring_frontier(r, &cursor, &reset);
+
+	// httpd тримає вказівники на значення до відправки заголовків
+	char hdr_next[16];
+	char hdr_ring[16];
+	snprintf(hdr_next, sizeof(hdr_next), "%lu", (unsigned long)next);
+	snprintf(hdr_ring, sizeof(hdr_ring), "%lu", (unsigned long)gen);
+	httpd_resp_set_hdr(req, "X-Log-Next", hdr_next);
+	httpd_resp_set_hdr(req, "X-Log-Reset", reset ? "1" : "0");
+	httpd_resp_set_hdr(req, "X-Log-Ring", hdr_ring);
+
+	// великий беклог (холодний старт дашборда) — стиснутим; дрібні long-poll відповіді — як є
+	resp_out_t out = { .req = req, .gz = NULL };
+	if (q->gzip && (uint32_t)(next - cursor) >= LOG_HTTP_GZIP_MIN && resp_gzip_begin(&out)) {
+		httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+	}
+	httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+	// 2) шматками прямо з арени; кожен запис перевіряється на перезапис під час копії
+	esp_err_t err = ESP_OK;
+	while ((int32_t)(next - cursor) > 0) {
+		bool lost = false;
+		uint32_t before = cursor;
+		size_t n = out.gz ? log_ring_read_fmt(r, &cursor, next, chunk, LOG_HTTP_CHUNK, &lost, q->fmt, &q->flt)
+				  : ring_read_cached(r, gen, &cursor, next, chunk, &lost, q);
+
+		// writer-и обігнали нас посеред відповіді: дірка перед цим шматком (log_ring_read_fmt),
+		// а X-Log-Next лишається валідним — тож мітка тут, і читаємо далі до next
+		if (lost) {
+			char mark[LOG_HTTP_LOST_MAX];
+			size_t ml = resp_lost_marker(q->fmt, before, mark);
+			if (ml > 0) err = resp_write(&out, mark, ml);
+			if (err != ESP_OK) break;
+		}
+
+		if (n > 0) {
+			err = resp_write(&out, chunk, n);
+			if (err != ESP_OK) break;
+		}
+
+		if (cursor == before) break;
+	}
+
+	free(chunk);
+	node_rings_release(r);
+	return resp_end(&out, err);
+}
+
+/*
+	Чи є що віддати клієнту. З фільтром — тільки записи, що проходять:
+	відфільтровані пропускаються і q->cursor одразу зсувається за них
+	(інакше кожне пробудження перевіряло б той самий хвіст заново).
+*/
+static bool log_has_news(log_query_t *q, log_ring_scratch_t *tmp)
+{
+	uint32_t gen = 0;
+	log_ring_t *r = query_ring_acquire(q, &gen);
+	if (!r) return false;
+
+	// вибір змінився — відповісти історією нового ring
+	bool news = (q->ring && q->ring != gen);
+	if (!news) {
+		bool reset = false;
+		uint32_t cursor = q->cursor;
+
+		if (log_ring_filter_empty(&q->flt)) {
+			uint32_t next = log_ring_frontier(r, &cursor, &reset);
+			news = reset || next != cursor;
+		} else {
+			news = log_ring_skip(r, &cursor, &q->flt, &reset, tmp) || reset;
+			if (!reset) q->cursor = cursor;
+		}
+	}
+
+	node_rings_release(r);
+	return news;
+}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+/* ----------------- WebSocket push ----------------- */
+
+/*
+	Формат повідомлень, перший рядок — заголовок (ASCII):
+	"L<next> <reset> <ring>\n<рядки лога>"	— нові рядки, next = cursor після них, ring = gen;
+						  з /ws?fmt=bin — binary кадр, рядки як у /log?fmt=bin
+	"N\n<json як у /nodes>"		— змінився список нод / вибір (text кадр)
+*/
+
+#define WS_HDR_RESERVE		24
+
+// WebSocket тримає сесію (не витісняється за неактивністю), поки відкритий
+static void ws_client_add(int fd, const log_query_t *q)
+{
+	uint32_t was = 0;
+
+	log_sessions_hold(q->sess, +1);
+
+	portENTER_CRITICAL(&s_ws_lock);
+	{
+		int slot = -1;
+		for (int i = 0; i < LOG_HTTP_WS_MAX; i++) {
+			if (s_ws[i].fd == fd) {
+				slot = i;
+				break;
+			}
+			if (slot < 0 && s_ws[i].fd < 0) slot = i;
+		}
+
+		if (slot >= 0) {
+			if (s_ws[slot].fd < 0) atomic_fetch_add_explicit(&s_ws_count, 1, memory_order_relaxed);
+			else was = s_ws[slot].q.sess;
+			s_ws[slot].fd = fd;
+			s_ws[slot].q = *q;
+			s_ws[slot].nodes_ver = 0;	// одразу віддамо список нод
+		} else {
+			was = q->sess;		// місця нема — сесію не тримаємо
+		}
+	}
+	portEXIT_CRITICAL(&s_ws_lock);
+
+	log_sessions_hold(was, -1);
+}
+
+static void ws_client_drop(int slot, int fd)
+{
+	uint32_t sess = 0;
+	bool dropped = false;
+
+	portENTER_CRITICAL(&s_ws_lock);
+	if (s_ws[slot].fd == fd) {
+		s_ws[slot].fd = -1;
+		sess = s_ws[slot].q.sess;
+		dropped = true;
+		atomic_fetch_sub_explicit(&s_ws_count, 1, memory_order_relaxed);
+	}
+	portEXIT_CRITICAL(&s_ws_lock);
+
+	if (dropped) log_sessions_hold(sess, -1);
+}
+
+static esp_err_t ws_send_frame(int fd, httpd_ws_type_t type, const char *data, size_t len)
+{
+	httpd_ws_frame_t f = {
+		.final		= true,
+		.fragmented	= false,
+		.type		= type,
+		.payload	= (uint8_t *)data,
+		.len		= len,
+	};
+	return httpd_ws_send_frame_async(s_http_server, fd, &f);
+}
+
+// JSON writer -> фрагменти одного text кадру (TEXT, CONTINUE..., останній з FIN)
+typedef struct {
+	int		fd;
+	bool		started;
+} ws_frag_t;
+
+static esp_err_t ws_frag_sink(void *ctx, const char *data, size_t len, bool last)
+{
+	ws_frag_t *fs = (ws_frag_t *)ctx;
+
+	httpd_ws_frame_t f = {
+		.final		= last,
+		.fragmented	= true,
+		.type		= fs->started ? HTTPD_WS_TYPE_CONTINUE : HTTPD_WS_TYPE_TEXT,
+		.payload	= (uint8_t *)data,
+		.len		= len,
+	};
+	fs->started = true;
+	return httpd_ws_send_frame_async(s_http_server, fs->fd, &f);
+}
+
+static esp_err_t ws_send_nodes(int fd, uint32_t sess)
+{
+	ws_frag_t fs = { .fd = fd, .started = false };
+
+	json_wr_t *w = (json_wr_t *)malloc(sizeof(json_wr_t));
+	if (!w) return ESP_ERR_NO_MEM;
+
+	w->sink = ws_frag_sink;
+	w->ctx = &fs;
+	w->err = ESP_OK;
+	w->len = 0;
+
+	nodes_expire();
+	jw_printf(w, "N\n");
+	nodes_json_write(w, sess);
+
+	esp_err_t err = jw_finish(w);
+	free(w);
+	return err;
+}
+
+// Все нове після q->cursor (до frontier на момент виклику), кількома кадрами якщо треба
+static esp_err_t ws_send_log(int fd, log_query_t *q)
+{
+	uint32_t gen = 0;
+	log_ring_t *r = query_ring_acquire(q, &gen);
+	if (!r) return ESP_OK;
+
+	uint32_t *cursor = &q->cursor;
+	*cursor = cursor_for(q->ring, gen, *cursor);
+	q->ring = gen;
+
+	bool reset = false;
+	uint32_t next = log_ring_frontier(r, cursor, &reset);
+
+	if (!reset && next == *cursor) {
+		node_rings_release(r);
+		return ESP_OK;
+	}
+
+	char *buf = (char *)malloc(WS_HDR_RESERVE + LOG_HTTP_CHUNK);
+	if (!buf) {
+		node_rings_release(r);
+		return ESP_ERR_NO_MEM;
+	}
+
+	esp_err_t err = ESP_OK;
+	do {
+		bool lost = false;
+		uint32_t before = *cursor;
+		char *body = buf + WS_HDR_RESERVE;
+		size_t n = ring_read_cached(r, gen, cursor, next, body, &lost, q);
+
+		// з фільтром шматок може бути порожнім — нема чого слати
+		if (n == 0 && !reset && !lost) {
+			if (*cursor == before) break;
+			continue;
+		}
+
+		// заголовок пишемо впритул перед тілом, щоб не копіювати тіло
+		char hdr[WS_HDR_RESERVE];
+		int hl = snprintf(hdr, sizeof(hdr), "L%lu %d %lu\n",
+			(unsigned long)*cursor, (reset || lost) ? 1 : 0, (unsigned long)gen);
+		memcpy(body - hl, hdr, hl);
+
+		httpd_ws_type_t type = (q->fmt == LOG_RING_FMT_BIN) ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT;
+		err = ws_send_frame(fd, type, body - hl, (size_t)hl + n);
+		reset = false;
+
+		if (lost || *cursor == before) break;
+	} while (err == ESP_OK && (int32_t)(next - *cursor) > 0);
+
+	free(buf);
+	node_rings_release(r);
+	return err;
+}
+
+static bool ws_has_news(log_ring_scratch_t *tmp)
+{
+	uint32_t nodes_ver = atomic_load_explicit(&s_nodes_ver, memory_order_relaxed);
+	bool news = false;
+
+	portENTER_CRITICAL(&s_ws_lock);
+	for (int i = 0; i < LOG_HTTP_WS_MAX && !news; i++) {
+		if (s_ws[i].fd < 0) continue;
+		if (s_ws[i].nodes_ver != nodes_ver) news = true;
+	}
+	portEXIT_CRITICAL(&s_ws_lock);
+
+	for (int i = 0; i < LOG_HTTP_WS_MAX && !news; i++) {
+		ws_client_t c;
+		portENTER_CRITICAL(&s_ws_lock);
+		c = s_ws[i];
+		portEXIT_CRITICAL(&s_ws_lock);
+
+		if (c.fd < 0) continue;
+
+		uint32_t was = c.q.cursor;
+		if (log_has_news(&c.q, tmp)) news = true;
+
+		// фільтр пропустив записи — запам'ятати, щоб не перевіряти їх знову
+		portENTER_CRITICAL(&s_ws_lock);
+		if (s_ws[i].fd == c.fd && s_ws[i].q.cursor == was) s_ws[i].q.cursor = c.q.cursor;
+		portEXIT_CRITICAL(&s_ws_lock);
+	}
+	return news;
+}
+
+static void ws_push_all(void)
+{
+	uint32_t nodes_ver = atomic_load_explicit(&s_nodes_ver, memory_order_relaxed);
+
+	for (int i = 0; i < LOG_HTTP_WS_MAX; i++) {
+		ws_client_t c;
+		portENTER_CRITICAL(&s_ws_lock);
+		c = s_ws[i];
+		portEXIT_CRITICAL(&s_ws_lock);
+
+		if (c.fd < 0) continue;
+
+		// клієнт закрився (або fd вже зайняв звичайний HTTP)
+		if (httpd_ws_get_fd_info(s_http_server, c.fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+			ws_client_drop(i, c.fd);
+			continue;
+		}
+
+		esp_err_t err = ESP_OK;
+		if (c.nodes_ver != nodes_ver) {
+			err = ws_send_nodes(c.fd, c.q.sess);
+			c.nodes_ver = nodes_ver;
+		}
+		if (err == ESP_OK) err = ws_send_log(c.fd, &c.q);
+
+		if (err != ESP_OK) {
+			ws_client_drop(i, c.fd);
+			httpd_sess_trigger_close(s_http_server, c.fd);
+			continue;
+		}
+
+		portENTER_CRITICAL(&s_ws_lock);
+		if (s_ws[i].fd == c.fd) {
+			s_ws[i].q = c.q;
+			s_ws[i].nodes_ver = c.nodes_ver;
+		}
+		portEXIT_CRITICAL(&s_ws_lock);
+	}
+}
+
+static esp_err_t http_ws_handler(httpd_req_t *req)
+{
+	// handshake: /ws?from=N&ring=G[&fmt=bin] — реєструємо сокет, далі пушить log_wait_task
+	if (req->method == HTTP_GET) {
+		char qs[96] = {0};
+		log_query_t q = { .fmt = LOG_RING_FMT_TEXT };
+
+		if (httpd_req_get_url_query_str(req, qs, sizeof(qs)) == ESP_OK) {
+			log_query_parse(qs, &q);
+		}
+		q.sess = req_session(req);
+
+		ws_client_add(httpd_req_to_sockfd(req), &q);
+		if (s_wait_task) xTaskNotifyGive(s_wait_task);
+		return ESP_OK;
+	}
+
+	// від клієнта нічого не чекаємо — просто вичитуємо кадр
+	httpd_ws_frame_t f;
+	memset(&f, 0, sizeof(f));
+
+	esp_err_t err = httpd_ws_recv_frame(req, &f, 0);
+	if (err != ESP_OK) return err;
+	if (f.len == 0) return ESP_OK;
+	if (f.len > 256) return ESP_FAIL;
+
+	uint8_t tmp[256];
+	f.payload = tmp;
+	return httpd_ws_recv_frame(req, &f, f.len);
+}
+#endif
+
+/*
+	Long-poll: припарковані запити тримає тільки ця таска (handler httpd вже повернувся).
+	Вона ж пушить у WebSocket. Будять її writer-и (log_wait_kick) або найближчий deadline.
+*/
+static void log_wait_task(void *arg)
+{
+	(void)arg;
+
+	log_wait_t parked[LOG_HTTP_WAIT_MAX];
+	uint32_t n = 0;
+
+	for (;;) {
+		// 1) спимо до нових рядків або до найближчого deadline
+		TickType_t now = xTaskGetTickCount();
+		TickType_t wait = portMAX_DELAY;
+		for (uint32_t i = 0; i < n; i++) {
+			TickType_t left = ((int32_t)(parked[i].deadline - now) > 0) ? (parked[i].deadline - now) : 0;
+			if (left < wait) wait = left;
+		}
+		ulTaskNotifyTake(pdTRUE, wait);
+
+		// 2) забрати нові припарковані запити
+		log_wait_t w;
+		while (n < LOG_HTTP_WAIT_MAX && xQueueReceive(s_wait_q, &w, 0) == pdTRUE) {
+			parked[n++] = w;
+		}
+
+		bool any_news = false;
+		for (uint32_t i = 0; i < n; i++) {
+			if (log_has_news(&parked[i].q, &s_wait_tmp)) {
+				any_news = true;
+				break;
+			}
+		}
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+		bool ws_news = (atomic_load_explicit(&s_ws_count, memory_order_relaxed) > 0) && ws_has_news(&s_wait_tmp);
+		any_news = any_news || ws_news;
+#endif
+
+		// пачка рядків зазвичай іде підряд — одна відповідь замість десятка
+		if (any_news) vTaskDelay(pdMS_TO_TICKS(LOG_HTTP_WAIT_COALESCE_MS));
+
+		// 3) відповісти тим, у кого є нове або вийшов час
+		now = xTaskGetTickCount();
+		for (uint32_t i = 0; i < n; ) {
+			bool expired = (int32_t)(now - parked[i].deadline) >= 0;
+			if (!expired && !log_has_news(&parked[i].q, &s_wait_tmp)) {
+				i++;
+				continue;
+			}
+
+			log_send_since(parked[i].req, &parked[i].q);
+			httpd_req_async_handler_complete(parked[i].req);
+			atomic_fetch_sub_explicit(&s_wait_parked, 1, memory_order_relaxed);
+
+			parked[i] = parked[--n];
+		}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+		// 4) WebSocket дашборди
+		if (ws_news) ws_push_all();
+#endif
+	}
+}
+
+static esp_err_t http_log_get(httpd_req_t *req)
+{
+	// /log?from=123[&ring=G][&wait=20000][&fmt=bin]
+	char qs[128] = {0};
+	log_query_t q = { .fmt = LOG_RING_FMT_TEXT };
+	uint32_t wait_ms = 0;
+
+	q.sess = req_session(req);
+	q.gzip = accepts_gzip(req);
+
+	if (httpd_req_get_url_query_str(req, qs, sizeof(qs)) == ESP_OK) {
+		char v[32] = {0};
+		log_query_parse(qs, &q);
+		if (httpd_query_key_value(qs, "wait", v, sizeof(v)) == ESP_OK) {
+			wait_ms = (uint32_t)strtoul(v, NULL, 10);
+			if (wait_ms > LOG_HTTP_WAIT_MAX_MS) wait_ms = LOG_HTTP_WAIT_MAX_MS;
+		}
+	}
+
+	// з фільтром рендер відкладених записів — у heap (стек httpd і так тісний); без пам'яті — відповідь одразу
+	log_ring_scratch_t *tmp = NULL;
+	if (wait_ms > 0 && !log_ring_filter_empty(&q.flt)) tmp = (log_ring_scratch_t *)malloc(sizeof(*tmp));
+
+	// є що віддати, або чекати не просили / нема куди паркувати — відповідаємо одразу
+	bool now = wait_ms == 0 || !s_wait_task || log_has_news(&q, tmp) ||
+		   atomic_load_explicit(&s_wait_parked, memory_order_relaxed) >= LOG_HTTP_WAIT_MAX;
+	free(tmp);
+	if (now) return log_send_since(req, &q);
+
+	log_wait_t w = {
+		.req		= NULL,
+		.q		= q,
+		.deadline	= xTaskGetTickCount() + pdMS_TO_TICKS(wait_ms),
+	};
+
+	if (httpd_req_async_handler_begin(req, &w.req) != ESP_OK) {
+		return log_send_since(req, &q);
+	}
+
+	// parked++ ДО передачі: writer, що допише рядок у цей момент, вже розбудить таску
+	atomic_fetch_add_explicit(&s_wait_parked, 1, memory_order_relaxed);
+	if (xQueueSend(s_wait_q, &w, 0) != pdTRUE) {
+		atomic_fetch_sub_explicit(&s_wait_parked, 1, memory_order_relaxed);
+		esp_err_t err = log_send_since(w.req, &q);
+		httpd_req_async_handler_complete(w.req);
+		return err;
+	}
+	xTaskNotifyGive(s_wait_task);
+
+	// httpd worker вільний, відповідь відправить log_wait_task
+	return ESP_OK;
+}
+
+/*
+	/log/download[?node=<mac>] — вся історія ноди одним .txt.gz (для експорту інциденту):
+	local з flash-розділом — з log_flash від найстарішого запису, інакше — весь RAM ring ноди
+	(вибраної сесією або node=). Завжди gzip як файл (application/gzip), не Content-Encoding.
+*/
+static esp_err_t http_log_download_get(httpd_req_t *req)
+{
+	char qs[64] = {0};
+	log_query_t q = { .fmt = LOG_RING_FMT_TEXT, .cursor = LOG_CURSOR_INVALID };
+
+	q.sess = req_session(req);
+	if (httpd_req_get_url_query_str(req, qs, sizeof(qs)) == ESP_OK) {
+		log_query_parse(qs, &q);
+	}
+
+	uint8_t mac[6];
+	if (q.has_node) mac_copy(mac, q.node);
+	else log_sessions_get(q.sess, mac, NULL, 0);
+
+	bool from_flash = mac_eq(mac, s_local_mac) && log_flash_ready();
+	log_ring_t *r = NULL;
+	if (!from_flash) {
+		r = query_ring_acquire(&q, NULL);
+		if (!r) {
+			httpd_resp_set_status(req, "404 Not Found");
+			httpd_resp_set_type(req, "text/plain");
+			return httpd_resp_send(req, "no log for this node\n", HTTPD_RESP_USE_STRLEN);
+		}
+	}
+
+	char *chunk = (char *)malloc(LOG_HTTP_CHUNK);
+	resp_out_t out = { .req = req, .gz = NULL };
+	if (!chunk || !resp_gzip_begin(&out)) {
+		free(chunk);
+		node_rings_release(r);
+		httpd_resp_set_status(req, "503 Service Unavailable");
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_send(req, "busy\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	char disp[64];
+	snprintf(disp, sizeof(disp), "attachment; filename=\"log-%02x%02x%02x%02x%02x%02x.txt.gz\"",
+		mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	httpd_resp_set_type(req, "application/gzip");
+	httpd_resp_set_hdr(req, "Content-Disposition", disp);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+	esp_err_t err = ESP_OK;
+	if (from_flash) {
+		// межа — те, що записано на момент запиту; далі по LOG_HTTP_HISTORY_MAX, як /log/history
+		log_flash_stats_t fs;
+		log_flash_get_stats(&fs);
+		uint32_t cursor = fs.oldest;
+
+		while (err == ESP_OK && (int32_t)(fs.next - cursor) > 0) {
+			bool reset = false;
+			uint32_t next = log_flash_frontier(&cursor, 0, LOG_HTTP_HISTORY_MAX, &reset);
+			if ((int32_t)(next - fs.next) > 0) next = fs.next;
+			if (next == cursor) break;
+
+			while (err == ESP_OK && (int32_t)(next - cursor) > 0) {
+				uint32_t before = cursor;
+				size_t n = log_flash_read(&cursor, next, chunk, LOG_HTTP_CHUNK, q.fmt);
+				if (n > 0) err = resp_write(&out, chunk, n);
+				if (cursor == before) break;
+			}
+			if (cursor != next) break;	// сектор стерли під нами — що встигли, те й віддали
+		}
+	} else {
+		bool reset = false;
+		uint32_t next = log_ring_frontier(r, &q.cursor, &reset);
+
+		while (err == ESP_OK && (int32_t)(next - q.cursor) > 0) {
+			bool lost = false;
+			uint32_t before = q.cursor;
+			size_t n = log_ring_read_fmt(r, &q.cursor, next, chunk, LOG_HTTP_CHUNK, &lost, q.fmt, &q.flt);
+
+			// як у log_send_since: переписане посеред файлу — мітка, і далі
+			if (lost) {
+				char mark[LOG_HTTP_LOST_MAX];
+				size_t ml = resp_lost_marker(q.fmt, before, mark);
+				if (ml > 0) err = resp_write(&out, mark, ml);
+			}
+			if (n > 0 && err == ESP_OK) err = resp_write(&out, chunk, n);
+			if (q.cursor == before) break;
+		}
+		node_rings_release(r);
+	}
+
+	free(chunk);
+	return resp_end(&out, err);
+}
+
+/*
+	/stream?node=<mac>&level=W&tags=wifi,mesh&mode=exclude — фільтр, з яким нода сама шле свій лог
+	(відфільтроване не йде в mesh, тож його не побачить жоден глядач цієї ноди).
+	level= порожній — всі рівні, tags= порожній — всі tag; mode=include (типово) | exclude.
+	Тільки node= — поточний фільтр.
+*/
+static esp_err_t http_stream_get(httpd_req_t *req)
+{
+	char qs[256] = {0};
+	char v[3 * NODE_DIR_FLT_TAGS + 1] = {0};
+	uint8_t mac[6];
+	node_dir_ent_t e;
+
+	if (httpd_req_get_url_query_str(req, qs, sizeof(qs)) != ESP_OK ||
+	    httpd_query_key_value(qs, "node", v, sizeof(v)) != ESP_OK ||
+	    !parse_mac_hex(v, mac) || !node_dir_get(mac, &e)) {
+		httpd_resp_set_status(req, "404 Not Found");
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_send(req, "unknown node\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	bool set = false;
+
+	if (httpd_query_key_value(qs, "level", v, sizeof(v)) == ESP_OK) {
+		e.flt_level = log_ring_level_of(v[0]);
+		set = true;
+	}
+	if (httpd_query_key_value(qs, "tags", v, sizeof(v)) == ESP_OK) {
+		size_t n = url_decode(v);
+		bool bad = n >= sizeof(e.flt_tags);
+		for (size_t i = 0; i < n && !bad; i++) {
+			bad = (uint8_t)v[i] < 0x20 || v[i] == '"' || v[i] == '\\';
+		}
+		if (bad) {
+			httpd_resp_set_status(req, "400 Bad Request");
+			httpd_resp_set_type(req, "text/plain");
+			return httpd_resp_send(req, "bad tags\n", HTTPD_RESP_USE_STRLEN);
+		}
+
+		memcpy(e.flt_tags, v, n + 1);
+		if (n == 0) e.flt_mode = MESH_LOG_CTRL_TAGS_NONE;
+		else if (e.flt_mode == MESH_LOG_CTRL_TAGS_NONE) e.flt_mode = MESH_LOG_CTRL_TAGS_INCLUDE;
+		set = true;
+	}
+	if (e.flt_tags[0] && httpd_query_key_value(qs, "mode", v, sizeof(v)) == ESP_OK) {
+		e.flt_mode = (strcmp(v, "exclude") == 0) ? MESH_LOG_CTRL_TAGS_EXCLUDE : MESH_LOG_CTRL_TAGS_INCLUDE;
+		set = true;
+	}
+
+	if (set && node_dir_set_filter(mac, e.flt_level, e.flt_mode, e.flt_tags)) {
+		// стрім уже йде — новий фільтр одразу; інакше піде з CTRL на першого глядача
+		if (log_sessions_viewers(mac) > 0) mesh_send_log_ctrl(mac, true, 0);
+	}
+
+	static const char s_lvl[] = "-EWIDV";
+	char out[160];
+	snprintf(out, sizeof(out),
+		"{\"node\":\"%02x%02x%02x%02x%02x%02x\",\"level\":\"%c\",\"mode\":\"%s\",\"tags\":\"%s\"}",
+		mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+		e.flt_level < sizeof(s_lvl) - 1 ? s_lvl[e.flt_level] : '-',
+		e.flt_mode == MESH_LOG_CTRL_TAGS_INCLUDE ? "include" :
+		e.flt_mode == MESH_LOG_CTRL_TAGS_EXCLUDE ? "exclude" : "",
+		e.flt_tags);
+
+	httpd_resp_set_type(req, "application/json");
+	return httpd_resp_send(req, out, HTTPD_RESP_USE_STRLEN);
+}
+
+/*
+	Сторінка дашборда: main/web/index.html, стиснута gzip під час збірки (main/CMakeLists.txt)
+	і вбудована як бінарні дані. ETag — хеш стиснутих байтів, тож змінюється тільки з прошивкою.
+*/
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+
+static const char *root_etag(void)
+{
+	static char etag[12];
+
+	if (!etag[0]) {
+		// FNV-1a 32
+		uint32_t h = 2166136261u;
+		for (const uint8_t *p = index_html_gz_start; p < index_html_gz_end; p++) {
+			h ^= *p;
+			h *= 16777619u;
+		}
+		snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)h);
+	}
+	return etag;
+}
+
+static esp_err_t http_root_get(httpd_req_t *req)
+{
+	const char *etag = root_etag();
+
+	// no-cache: браузер тримає копію, але щоразу перепитує (після OTA сторінка оновиться)
+	httpd_resp_set_hdr(req, "ETag", etag);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+	httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+	if (etag_matches(req, etag)) {
+		httpd_resp_set_status(req, "304 Not Modified");
+		return httpd_resp_send(req, NULL, 0);
+	}
+
+	// у прошивці сторінка лише стиснута (inflate на льоту не тягнемо); без gzip — хіба curl без --compressed
+	if (!accepts_gzip(req)) {
+		httpd_resp_set_status(req, "406 Not Acceptable");
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_send(req, "page is served gzip-only; send Accept-Encoding: gzip\n", HTTPD_RESP_USE_STRLEN);
+	}
+
+	httpd_resp_set_type(req, "text/html");
+	httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+	return httpd_resp_send(req, (const char *)index_html_gz_start, index_html_gz_end - index_html_gz_start);
+}
+
+
+/* ----------------- Public API ----------------- */
+
+esp_err_t log_http_server_init(void)
+{
+	esp_wifi_get_mac(WIFI_IF_STA, s_local_mac);
 
-	// selected = local
-	mac_copy(s_sel_mac, s_local_mac);
 	strncpy(s_local_tag, "node0", sizeof(s_local_tag) - 1);
 	s_local_tag[sizeof(s_local_tag) - 1] = '\0';
-	strncpy(s_sel_tag, s_local_tag, sizeof(s_sel_tag) - 1);
-	s_sel_tag[sizeof(s_sel_tag) - 1] = '\0';
+
+	s_boot_id = esp_random();
+
+	// local ring — закріплений у node_rings; remote створюються на першого глядача
+	node_rings_init(s_local_mac, &s_ring, on_ring_evicted);
+
+	// без сесії клієнт бачить local
+	log_sessions_init(s_local_mac, s_local_tag, on_session_view);
+	log_resp_cache_init();
 
 	// vprintf hook
 	s_orig_vprintf = (vprintf_like_t)esp_log_set_vprintf(&log_http_vprintf);
 
 	ESP_LOGI(TAG, "log_http_server_init: vprintf hook installed");
+
+	// історія у flash — тільки якщо є розділ (за замовчуванням таблиця без нього)
+	esp_err_t ferr = log_flash_start(&s_ring);
+	if (ferr != ESP_OK && ferr != ESP_ERR_NOT_FOUND) {
+		ESP_LOGW(TAG, "log_flash_start: %s", esp_err_to_name(ferr));
+	}
 	return ESP_OK;
 }
 
@@ -725,6 +2167,7 @@ esp_err_t log_http_server_start(void)
 	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 	config.stack_size = 5128;
 	config.lru_purge_enable = true;
+	config.max_uri_handlers = 16;
 
 	esp_err_t err = httpd_start(&s_http_server, &config);
 	if (err != ESP_OK) {
@@ -767,11 +2210,79 @@ esp_err_t log_http_server_start(void)
 		.user_ctx	= NULL
 	};
 
+	httpd_uri_t uri_stats = {
+		.uri		= "/stats",
+		.method		= HTTP_GET,
+		.handler	= http_stats_get,
+		.user_ctx	= NULL
+	};
+
+	httpd_uri_t uri_budget = {
+		.uri		= "/budget",
+		.method		= HTTP_GET,
+		.handler	= http_budget_get,
+		.user_ctx	= NULL
+	};
+
+	httpd_uri_t uri_history = {
+		.uri		= "/log/history",
+		.method		= HTTP_GET,
+		.handler	= http_log_history_get,
+		.user_ctx	= NULL
+	};
+
 	httpd_register_uri_handler(s_http_server, &uri_root);
 	httpd_register_uri_handler(s_http_server, &uri_log);
 	httpd_register_uri_handler(s_http_server, &uri_nodes);
 	httpd_register_uri_handler(s_http_server, &uri_select);
 	httpd_register_uri_handler(s_http_server, &uri_clear);
+	httpd_register_uri_handler(s_http_server, &uri_stats);
+	httpd_register_uri_handler(s_http_server, &uri_budget);
+	httpd_register_uri_handler(s_http_server, &uri_history);
+
+	httpd_uri_t uri_download = {
+		.uri		= "/log/download",
+		.method		= HTTP_GET,
+		.handler	= http_log_download_get,
+		.user_ctx	= NULL
+	};
+	httpd_register_uri_handler(s_http_server, &uri_download);
+
+	httpd_uri_t uri_metrics = {
+		.uri		= "/metrics",
+		.method		= HTTP_GET,
+		.handler	= http_metrics_get,
+		.user_ctx	= NULL
+	};
+	httpd_register_uri_handler(s_http_server, &uri_metrics);
+
+	httpd_uri_t uri_stream = {
+		.uri		= "/stream",
+		.method		= HTTP_GET,
+		.handler	= http_stream_get,
+		.user_ctx	= NULL
+	};
+	httpd_register_uri_handler(s_http_server, &uri_stream);
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+	httpd_uri_t uri_ws = {
+		.uri		= "/ws",
+		.method		= HTTP_GET,
+		.handler	= http_ws_handler,
+		.user_ctx	= NULL,
+		.is_websocket	= true
+	};
+	httpd_register_uri_handler(s_http_server, &uri_ws);
+#endif
+
+	if (!s_wait_task) {
+		s_wait_q = xQueueCreate(LOG_HTTP_WAIT_MAX, sizeof(log_wait_t));
+		if (!s_wait_q || xTaskCreate(log_wait_task, "log_wait", 4096, NULL, 5, &s_wait_task) != pdPASS) {
+			// без таски /log просто відповідає одразу (як звичайний poll)
+			ESP_LOGE(TAG, "failed to create log_wait task");
+			s_wait_task = NULL;
+		}
+	}
 
 	ESP_LOGI(TAG, "HTTP log server started");
 	return ESP_OK;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -10,12 +11,19 @@ extern "C" {
 esp_err_t log_http_server_init(void);
 esp_err_t log_http_server_start(void);
 
-// Викликає root при RX: NODEINFO
-void log_http_server_node_seen(const uint8_t mac[6], const char *tag);
+// Викликає root при RX: NODEINFO (tag_id 0 — без id, напр. LOG_LINE)
+void log_http_server_node_seen(const uint8_t mac[6], const char *tag, uint8_t tag_id);
+
+// Викликає root при RX: LOG_BATCH (лише tag_id; невідомий id — root просить NODEINFO)
+void log_http_server_node_seen_id(const uint8_t mac[6], uint8_t tag_id);
 
 // Викликає root при RX: LOG_LINE
 void log_http_server_remote_line(const uint8_t mac[6], const char *tag, const char *line);
 
+// Викликає root при RX: LOG_BATCH (seq = h.counter, flags/data/count — як у mesh_log_batch_packet_t)
+void log_http_server_remote_batch(const uint8_t mac[6], uint32_t seq, uint8_t flags,
+				  const uint8_t *data, size_t len, uint8_t count);
+
 #ifdef __cplusplus
 }
 #endif
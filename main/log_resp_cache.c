@@ -0,0 +1,111 @@
+#include "log_resp_cache.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef struct {
+	bool			used;
+	uint32_t		gen;
+	uint32_t		from;
+	uint32_t		to;
+	log_ring_fmt_t		fmt;
+	log_ring_filter_t	flt;		// копія (порожній — без фільтра)
+	uint32_t		stamp;		// для LRU
+	size_t			len;
+	char			data[LOG_RESP_CACHE_BYTES];
+} slot_t;
+
+static slot_t s_slot[LOG_RESP_CACHE_SLOTS];
+static SemaphoreHandle_t s_mtx = NULL;
+static uint32_t s_stamp = 0;
+
+static _Atomic uint32_t s_hits = 0;
+static _Atomic uint32_t s_misses = 0;
+
+// значущі байти фільтра: хвости tag/find за *_len не порівнюємо
+static bool flt_eq(const log_ring_filter_t *a, const log_ring_filter_t *b)
+{
+	static const log_ring_filter_t none = { 0 };
+	if (!a) a = &none;
+	if (!b) b = &none;
+
+	return a->max_level == b->max_level &&
+		a->tag_len == b->tag_len && memcmp(a->tag, b->tag, a->tag_len) == 0 &&
+		a->find_len == b->find_len && memcmp(a->find, b->find, a->find_len) == 0;
+}
+
+// під mutex
+static slot_t *find(const log_resp_key_t *k)
+{
+	for (int i = 0; i < LOG_RESP_CACHE_SLOTS; i++) {
+		slot_t *s = &s_slot[i];
+		if (!s->used || s->gen != k->gen || s->from != k->from || s->to != k->to) continue;
+		if (s->fmt != k->fmt || !flt_eq(&s->flt, k->flt)) continue;
+		return s;
+	}
+	return NULL;
+}
+
+void log_resp_cache_init(void)
+{
+	if (!s_mtx) s_mtx = xSemaphoreCreateMutex();
+}
+
+bool log_resp_cache_get(const log_resp_key_t *k, char *out, size_t cap, size_t *len)
+{
+	if (!s_mtx) return false;
+
+	bool hit = false;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+	slot_t *s = find(k);
+	if (s && s->len <= cap) {
+		memcpy(out, s->data, s->len);
+		*len = s->len;
+		s->stamp = ++s_stamp;
+		hit = true;
+	}
+	xSemaphoreGive(s_mtx);
+
+	atomic_fetch_add_explicit(hit ? &s_hits : &s_misses, 1, memory_order_relaxed);
+	return hit;
+}
+
+void log_resp_cache_put(const log_resp_key_t *k, const char *data, size_t len)
+{
+	if (!s_mtx || len > LOG_RESP_CACHE_BYTES) return;
+
+	xSemaphoreTake(s_mtx, portMAX_DELAY);
+	if (!find(k)) {
+		// вільний слот, інакше — найдавніше використаний
+		slot_t *s = &s_slot[0];
+		for (int i = 0; i < LOG_RESP_CACHE_SLOTS; i++) {
+			if (!s_slot[i].used) {
+				s = &s_slot[i];
+				break;
+			}
+			if ((int32_t)(s_slot[i].stamp - s->stamp) < 0) s = &s_slot[i];
+		}
+
+		s->used = true;
+		s->gen = k->gen;
+		s->from = k->from;
+		s->to = k->to;
+		s->fmt = k->fmt;
+		if (k->flt) s->flt = *k->flt;
+		else memset(&s->flt, 0, sizeof(s->flt));
+		s->stamp = ++s_stamp;
+		s->len = len;
+		memcpy(s->data, data, len);
+	}
+	xSemaphoreGive(s_mtx);
+}
+
+void log_resp_cache_get_stats(log_resp_cache_stats_t *out)
+{
+	out->hits = atomic_load_explicit(&s_hits, memory_order_relaxed);
+	out->misses = atomic_load_explicit(&s_misses, memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Кеш готових шматків /log і /ws: кілька дашбордів на тому самому ring і cursor
+	(після першої відповіді всі доходять до однакового X-Log-Next) отримують ті самі байти —
+	рендеримо їх один раз, а не на кожного клієнта.
+	- ключ: ring (gen), [from, to), формат і фільтр; записи в ring не змінюються, тож шматок
+	  валідний, поки from ще у вікні (це перевіряє frontier до пошуку в кеші)
+	- нові рядки зсувають frontier — це вже інший ключ, старі записи просто витісняються
+	- тільки шматки до LOG_RESP_CACHE_BYTES (звичайна long-poll/push відповідь), без gzip
+*/
+
+#ifndef LOG_RESP_CACHE_SLOTS
+	#define LOG_RESP_CACHE_SLOTS		3
+#endif
+
+#ifndef LOG_RESP_CACHE_BYTES
+	#define LOG_RESP_CACHE_BYTES		1536	// = LOG_HTTP_CHUNK: один шматок відповіді
+#endif
+
+typedef struct {
+	uint32_t		gen;		// node_rings gen (унікальний на весь час роботи)
+	uint32_t		from;
+	uint32_t		to;
+	log_ring_fmt_t		fmt;
+	const log_ring_filter_t	*flt;		// NULL — без фільтра
+} log_resp_key_t;
+
+typedef struct {
+	uint32_t	hits;
+	uint32_t	misses;
+} log_resp_cache_stats_t;
+
+void		log_resp_cache_init(void);
+
+// Скопіювати шматок для k у out. false — нема (або не влазить у cap).
+bool		log_resp_cache_get(const log_resp_key_t *k, char *out, size_t cap, size_t *len);
+
+// Запам'ятати відрендерений шматок (цілий [from, to)); більші за LOG_RESP_CACHE_BYTES ігноруються
+void		log_resp_cache_put(const log_resp_key_t *k, const char *data, size_t len);
+
+void		log_resp_cache_get_stats(log_resp_cache_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,662 @@
+#include "log_ring.h"
+
+#include <string.h>
+
+#include "log_clock.h"
+#include "log_defer.h"
+
+/*
+	Як це працює:
+	1) writer робить CAS head += need (need = max можливий розмір запису). Якщо запис
+	   не влазить до кінця буфера — хвіст закривається pad-записом і резерв іде з нуля.
+	2) штамп заголовка = pos|1 ("пишеться"), текст пишеться прямо в арену.
+	3) commit: якщо після нас ніхто не резервував — повертаємо head назад до фактичного
+	   розміру (CAS), інакше запис просто займає весь резерв. Потім stride/len/meta і штамп = pos.
+	4) reader йде від cursor по stride; запис валідний якщо штамп == pos, а після копії
+	   head не відійшов далі ніж на size (інакше його вже переписали).
+*/
+
+#define HDR_SIZE		((uint32_t)sizeof(log_rec_hdr_t))
+
+_Static_assert(sizeof(log_rec_hdr_t) == 16, "log_rec_hdr_t must stay 16 bytes");
+#define REC_MAX			LOG_RING_ALIGN_UP(HDR_SIZE + LOG_RING_LINE_MAX)
+
+// якщо cursor не опублікований, але лежить отут біля head — це writer, який ще не поставив штамп
+#define WAIT_WINDOW		(4 * REC_MAX)
+
+static inline log_rec_hdr_t *rec_at(const log_ring_t *r, uint32_t pos)
+{
+	return (log_rec_hdr_t *)(r->buf + (pos & (r->size - 1)));
+}
+
+// Нижня межа вікна: max(floor, head - size)
+static uint32_t ring_lower(const log_ring_t *r, uint32_t head)
+{
+	uint32_t fl = atomic_load_explicit(&r->floor, memory_order_acquire);
+	if ((uint32_t)(head - fl) <= r->size) return fl;
+	return head - r->size;
+}
+
+static bool in_window(uint32_t p, uint32_t lower, uint32_t head)
+{
+	return (uint32_t)(head - p) <= (uint32_t)(head - lower);
+}
+
+static bool rec_sane(const log_ring_t *r, uint32_t pos, uint32_t stride, uint32_t len)
+{
+	uint32_t off = pos & (r->size - 1);
+
+	if (stride < HDR_SIZE || stride > REC_MAX) return false;
+	if (stride & (LOG_RING_ALIGN - 1)) return false;
+	if (off + stride > r->size) return false;
+	if (len > stride - HDR_SIZE) return false;
+	return true;
+}
+
+static bool hdr_sane(const log_ring_t *r, uint32_t pos, const log_rec_hdr_t *h)
+{
+	return rec_sane(r, pos, h->stride, h->len);
+}
+
+// Один знімок stride/len (заголовок можуть переписувати паралельно — межі беремо тільки з нього)
+static bool hdr_load(const log_ring_t *r, uint32_t pos, const log_rec_hdr_t *h, uint32_t *stride, size_t *len)
+{
+	*stride = h->stride;
+	*len = h->len;
+	return rec_sane(r, pos, *stride, (uint32_t)*len);
+}
+
+// Якщо заголовок не влазить до кінця буфера — там неявний pad
+static uint32_t skip_tail(const log_ring_t *r, uint32_t p)
+{
+	uint32_t off = p & (r->size - 1);
+	if (off + HDR_SIZE > r->size) return p + (r->size - off);
+	return p;
+}
+
+// Пошук першої межі запису в [from, head): самоописні штампи дозволяють синхронізуватись з будь-якого місця
+static uint32_t ring_seek(const log_ring_t *r, uint32_t from, uint32_t head)
+{
+	uint32_t p = LOG_RING_ALIGN_UP(from);
+
+	while ((int32_t)(head - p) > 0) {
+		uint32_t q = skip_tail(r, p);
+		if (q != p) {
+			p = q;
+			continue;
+		}
+
+		const log_rec_hdr_t *h = rec_at(r, p);
+		uint32_t stamp = atomic_load_explicit(&h->pos, memory_order_acquire);
+		if (stamp == (p | 1)) return p;
+		if (stamp == p && hdr_sane(r, p, h)) return p;
+
+		p += LOG_RING_ALIGN;
+	}
+	return head;
+}
+
+void log_ring_init(log_ring_t *r, void *buf, uint32_t size)
+{
+	memset(r, 0, sizeof(*r));
+	r->buf = (uint8_t *)buf;
+	r->size = size;
+	memset(buf, 0, size);
+}
+
+void log_ring_clear(log_ring_t *r)
+{
+	// нічого не чистимо фізично — просто зсуваємо нижню межу видимості
+	atomic_store_explicit(&r->floor, atomic_load_explicit(&r->head, memory_order_relaxed), memory_order_release);
+}
+
+uint32_t log_ring_next(const log_ring_t *r)
+{
+	return atomic_load_explicit(&r->head, memory_order_acquire);
+}
+
+uint32_t log_ring_used(const log_ring_t *r)
+{
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	return head - ring_lower(r, head);
+}
+
+char *log_ring_reserve(log_ring_t *r, size_t max_len, log_ring_wr_t *wr)
+{
+	if (max_len > LOG_RING_LINE_MAX) max_len = LOG_RING_LINE_MAX;
+
+	uint32_t need = LOG_RING_ALIGN_UP(HDR_SIZE + (uint32_t)max_len);
+	uint32_t old = atomic_load_explicit(&r->head, memory_order_relaxed);
+	uint32_t pad = 0;
+
+	do {
+		uint32_t off = old & (r->size - 1);
+		pad = (off + need > r->size) ? (r->size - off) : 0;
+	} while (!atomic_compare_exchange_weak_explicit(&r->head, &old, old + pad + need,
+			memory_order_acq_rel, memory_order_relaxed));
+
+	if (pad >= HDR_SIZE) {
+		log_rec_hdr_t *ph = rec_at(r, old);
+		ph->stride = (uint16_t)pad;
+		ph->len = 0;
+		atomic_store_explicit(&ph->pos, old, memory_order_release);
+	}
+
+	uint32_t pos = old + pad;
+	log_rec_hdr_t *h = rec_at(r, pos);
+	atomic_store_explicit(&h->pos, pos | 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	wr->pos = pos;
+	wr->need = need;
+	wr->cap = need - HDR_SIZE;
+	return (char *)(h + 1);
+}
+
+void log_ring_commit(log_ring_t *r, const log_ring_wr_t *wr, size_t len, const log_rec_meta_t *meta)
+{
+	if (len > LOG_RING_LINE_MAX) len = LOG_RING_LINE_MAX;
+	if (len > wr->cap) len = wr->cap;
+
+	/*
+		Writer-а витіснили між reserve і commit, і інші обігнали його більш ніж на size:
+		місце вже належить новішим записам. Штамп тут зробив би з них сміття для читачів —
+		рядок відкидаємо. (Текст, якщо його вже писали, міг зачепити новіший запис; seqlock
+		читача цього не бачить, але це тільки текст, не межі записів.)
+	*/
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	if ((uint32_t)(head - wr->pos) > r->size) {
+		atomic_fetch_add_explicit(&r->lapped, 1, memory_order_relaxed);
+		return;
+	}
+
+	// порожній commit (len 0) без наступників — віддаємо резерв повністю, заголовка не лишається
+	uint32_t stride = len ? LOG_RING_ALIGN_UP(HDR_SIZE + (uint32_t)len) : 0;
+	if (stride < wr->need) {
+		// віддаємо зайве назад, тільки якщо після нас ніхто не резервував
+		uint32_t expect = wr->pos + wr->need;
+		if (atomic_compare_exchange_strong_explicit(&r->head, &expect, wr->pos + stride,
+				memory_order_acq_rel, memory_order_relaxed)) {
+			// /clear між reserve і commit поставив floor на старий head — тягнемо його слідом
+			expect = wr->pos + wr->need;
+			atomic_compare_exchange_strong_explicit(&r->floor, &expect, wr->pos + stride,
+				memory_order_acq_rel, memory_order_relaxed);
+			if (stride == 0) return;
+		} else {
+			// інакше хвіст резерву — окремий pad (як на межі буфера), а не частина запису;
+			// порожній запис тоді лишається мінімальним заголовком
+			if (stride == 0) stride = LOG_RING_ALIGN_UP(HDR_SIZE);
+			uint32_t slack = wr->need - stride;
+			if (slack >= HDR_SIZE) {
+				log_rec_hdr_t *ph = rec_at(r, wr->pos + stride);
+				ph->stride = (uint16_t)slack;
+				ph->len = 0;
+				atomic_store_explicit(&ph->pos, wr->pos + stride, memory_order_release);
+			} else {
+				stride = wr->need;
+			}
+		}
+	}
+
+	log_rec_hdr_t *h = rec_at(r, wr->pos);
+	h->stride = (uint16_t)stride;
+	h->len = (uint16_t)len;
+	h->ts = meta ? meta->ts : 0;
+	h->ms = (meta && meta->ms < 1000) ? meta->ms : 0;
+	h->level = meta ? (meta->level & 7) : LOG_RING_LVL_NONE;
+	h->deferred = (meta && meta->deferred) ? 1 : 0;
+	h->rsv = 0;
+	if (meta && !meta->deferred && meta->tag_len > 0 && (size_t)meta->tag_off + meta->tag_len <= len) {
+		h->tag_off = meta->tag_off;
+		h->tag_len = meta->tag_len;
+	} else {
+		h->tag_off = 0;
+		h->tag_len = 0;
+	}
+	atomic_store_explicit(&h->pos, wr->pos, memory_order_release);
+
+	atomic_fetch_add_explicit(&r->appends, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&r->bytes, stride, memory_order_relaxed);
+	if (h->deferred) atomic_fetch_add_explicit(&r->deferred, 1, memory_order_relaxed);
+}
+
+void log_ring_append(log_ring_t *r, const char *line, size_t len, const log_rec_meta_t *meta)
+{
+	if (!line) return;
+
+	if (len > LOG_RING_LINE_MAX) {
+		len = LOG_RING_LINE_MAX;
+		atomic_fetch_add_explicit(&r->truncated, 1, memory_order_relaxed);
+	}
+
+	log_ring_wr_t wr;
+	char *dst = log_ring_reserve(r, len, &wr);
+	memcpy(dst, line, len);
+	log_ring_commit(r, &wr, len, meta);
+}
+
+uint8_t log_ring_level_of(char c)
+{
+	switch (c) {
+	case 'E': return LOG_RING_LVL_E;
+	case 'W': return LOG_RING_LVL_W;
+	case 'I': return LOG_RING_LVL_I;
+	case 'D': return LOG_RING_LVL_D;
+	case 'V': return LOG_RING_LVL_V;
+	default:  return LOG_RING_LVL_NONE;
+	}
+}
+
+void log_ring_parse_line(const char *s, size_t len, log_rec_meta_t *m)
+{
+	size_t i = 0;
+
+	m->level = LOG_RING_LVL_NONE;
+	m->tag_off = 0;
+	m->tag_len = 0;
+
+	if (len > 1 && s[0] == '\033' && s[1] == '[') {
+		while (i < len && s[i] != 'm') i++;
+		i++;
+	}
+	if (i + 2 >= len || s[i + 1] != ' ') return;
+
+	m->level = log_ring_level_of(s[i]);
+	if (m->level == LOG_RING_LVL_NONE || s[i + 2] != '(') return;
+
+	// ") " після uptime
+	i += 3;
+	while (i < len && s[i] != ')') i++;
+	if (i + 2 >= len || s[i + 1] != ' ') return;
+	i += 2;
+
+	// "[час] " від log_time_vprintf
+	if (s[i] == '[') {
+		while (i < len && s[i] != ']') i++;
+		if (i + 2 >= len || s[i + 1] != ' ') return;
+		i += 2;
+	}
+
+	// tag до ": "
+	size_t t0 = i;
+	while (i < len && i - t0 < LOG_RING_TAG_MAX && s[i] != ':') i++;
+	if (i + 1 >= len || s[i] != ':' || s[i + 1] != ' ' || i == t0 || t0 > 255) return;
+
+	m->tag_off = (uint8_t)t0;
+	m->tag_len = (uint8_t)(i - t0);
+}
+
+// Читач втратив позицію (ring обігнав, /clear, чужий cursor)
+static void reader_reset(log_ring_t *r, bool *reset)
+{
+	if (reset) *reset = true;
+	atomic_fetch_add_explicit(&r->resets, 1, memory_order_relaxed);
+}
+
+// Валідація cursor: повертає позицію, з якої реально читати
+static uint32_t ring_start(log_ring_t *r, uint32_t p, uint32_t lower, uint32_t head, bool *reset)
+{
+	if (!in_window(p, lower, head) || (p & (LOG_RING_ALIGN - 1))) {
+		reader_reset(r, reset);
+		return ring_seek(r, lower, head);
+	}
+
+	if (p != head) {
+		uint32_t q = skip_tail(r, p);
+		const log_rec_hdr_t *h = rec_at(r, q);
+		uint32_t stamp = atomic_load_explicit(&h->pos, memory_order_acquire);
+
+		if (stamp != q && stamp != (q | 1) && (uint32_t)(head - p) > WAIT_WINDOW) {
+			// такої межі запису немає (напр. cursor з попереднього boot)
+			reader_reset(r, reset);
+			return ring_seek(r, lower, head);
+		}
+	}
+	return p;
+}
+
+uint32_t log_ring_frontier(log_ring_t *r, uint32_t *cursor, bool *reset)
+{
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	uint32_t p = ring_start(r, *cursor, ring_lower(r, head), head, reset);
+
+	*cursor = p;
+
+	// тільки заголовки, без копіювання тексту
+	while ((int32_t)(head - p) > 0) {
+		uint32_t q = skip_tail(r, p);
+		if (q != p) {
+			p = q;
+			continue;
+		}
+
+		const log_rec_hdr_t *h = rec_at(r, p);
+		if (atomic_load_explicit(&h->pos, memory_order_acquire) != p || !hdr_sane(r, p, h)) break;
+		p += h->stride;
+	}
+	return p;
+}
+
+// Префікс часу для TEXT; рядки йдуть пачками з тим самим ts — дату беремо раз на секунду
+typedef struct {
+	uint32_t	ts;
+	size_t		len;		// 0 — ще не рендерили
+	bool		valid;
+	char		s[LOG_CLOCK_DATE_LEN + 2];
+} ts_prefix_t;
+
+static size_t text_prefix(ts_prefix_t *c, uint32_t ts, uint16_t ms, char *out)
+{
+	if (c->len == 0 || c->ts != ts) {
+		c->s[0] = '[';
+		c->len = 1 + log_clock_format(ts, c->s + 1, sizeof(c->s) - 1);
+		c->valid = (c->len > 1);
+		c->ts = ts;
+	}
+
+	if (!c->valid) {
+		memcpy(out, "[no-time] ", 10);
+		return 10;
+	}
+
+	// "[YYYY-MM-DD HH:MM:SS" + ".mmm] "
+	memcpy(out, c->s, c->len);
+	out[c->len] = '.';
+	out[c->len + 1] = (char)('0' + (ms / 100) % 10);
+	out[c->len + 2] = (char)('0' + (ms / 10) % 10);
+	out[c->len + 3] = (char)('0' + ms % 10);
+	out[c->len + 4] = ']';
+	out[c->len + 5] = ' ';
+	return c->len + 6;
+}
+
+static void put_u16(char *p, uint16_t v)
+{
+	p[0] = (char)(v & 0xFF);
+	p[1] = (char)(v >> 8);
+}
+
+static void put_u32(char *p, uint32_t v)
+{
+	put_u16(p, (uint16_t)(v & 0xFFFF));
+	put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static bool text_has(const char *s, size_t len, const char *needle, size_t nlen)
+{
+	if (nlen == 0) return true;
+	if (nlen > len) return false;
+
+	for (size_t i = 0; i + nlen <= len; i++) {
+		if (s[i] == needle[0] && memcmp(s + i, needle, nlen) == 0) return true;
+	}
+	return false;
+}
+
+static bool level_match(uint8_t lvl, const log_ring_filter_t *flt)
+{
+	return !flt || !flt->max_level || (lvl != LOG_RING_LVL_NONE && lvl <= flt->max_level);
+}
+
+// Чи потрібен текст (для відкладених записів — рендер), чи досить рівня з заголовка
+static bool filter_needs_text(const log_ring_filter_t *flt)
+{
+	return !log_ring_filter_empty(flt) && (flt->tag_len || flt->find_len);
+}
+
+/*
+	Текст може бути прямо в арені: тоді результат має сенс тільки після seqlock перевірки.
+	len — вже перевірений hdr_sane (заголовок можуть переписувати паралельно, тож межі — тільки від нього).
+*/
+static bool text_match(uint8_t lvl, size_t tag_off, size_t tag_len, const char *text, size_t len,
+		const log_ring_filter_t *flt)
+{
+	if (log_ring_filter_empty(flt)) return true;
+
+	if (!level_match(lvl, flt)) return false;
+	if (flt->tag_len) {
+		if (tag_len != flt->tag_len || tag_off + tag_len > len || memcmp(text + tag_off, flt->tag, tag_len) != 0) return false;
+	}
+	if (flt->find_len) {
+		if (!text_has(text, len, flt->find, flt->find_len)) return false;
+	}
+	return true;
+}
+
+static bool rec_match(const log_rec_hdr_t *h, size_t len, const log_ring_filter_t *flt)
+{
+	return text_match(h->level, h->tag_off, h->tag_len, (const char *)(h + 1), len, flt);
+}
+
+/*
+	Відкладений запис: рендер з копії аргументів (вже після seqlock перевірки),
+	tag шукаємо в готовому тексті. out має вміщати LOG_RING_LINE_MAX + 1.
+	0 — не пройшов фільтр або битий.
+*/
+static size_t deferred_render(const uint8_t *raw, size_t raw_len, uint8_t lvl, char *out,
+		const log_ring_filter_t *flt)
+{
+	size_t len = log_defer_render(raw, raw_len, out, LOG_RING_LINE_MAX + 1);
+	if (len == 0 || log_ring_filter_empty(flt)) return len;
+
+	log_rec_meta_t m;
+	log_ring_parse_line(out, len, &m);
+	return text_match(lvl, m.tag_off, m.tag_len, out, len, flt) ? len : 0;
+}
+
+static void bin_hdr(char *b, uint32_t pos, uint32_t ts, uint16_t ms, uint8_t lvl, size_t len)
+{
+	put_u32(b, pos);
+	put_u32(b + 4, ts);
+	put_u16(b + 8, ms);
+	b[10] = (char)lvl;
+	b[11] = 0;
+	put_u16(b + 12, (uint16_t)len);
+}
+
+size_t log_ring_fmt_prefix(log_ring_fmt_t fmt, uint32_t pos, const log_rec_meta_t *m, size_t len, char *out)
+{
+	if (fmt == LOG_RING_FMT_BIN) {
+		bin_hdr(out, pos, m->ts, m->ms, m->level, len);
+		return LOG_RING_BIN_HDR;
+	}
+
+	ts_prefix_t tsp = { .len = 0 };
+	return text_prefix(&tsp, m->ts, m->ms, out);
+}
+
+// seqlock: якщо за час читання writer-и пішли далі ніж на size — запис p вже переписаний
+static bool rec_overwritten(const log_ring_t *r, uint32_t p, uint32_t *head)
+{
+	atomic_thread_fence(memory_order_acquire);
+	uint32_t h2 = atomic_load_explicit(&r->head, memory_order_relaxed);
+	if ((uint32_t)(h2 - p) <= r->size) return false;
+
+	*head = h2;
+	return true;
+}
+
+size_t log_ring_read_fmt(log_ring_t *r, uint32_t *cursor, uint32_t end, char *out, size_t cap,
+		bool *reset, log_ring_fmt_t fmt, const log_ring_filter_t *flt)
+{
+	ts_prefix_t tsp = { .len = 0 };
+
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	uint32_t p = ring_start(r, *cursor, ring_lower(r, head), head, reset);
+	size_t used = 0;
+
+	if ((int32_t)(end - head) > 0) end = head;
+
+	// копіюємо опубліковані записи
+	while ((int32_t)(end - p) > 0) {
+		uint32_t q = skip_tail(r, p);
+		if (q != p) {
+			p = q;
+			continue;
+		}
+
+		const log_rec_hdr_t *h = rec_at(r, p);
+		uint32_t stamp = atomic_load_explicit(&h->pos, memory_order_acquire);
+		if (stamp != p) break;		// ще пишеться — дочитаємо наступного разу
+
+		uint32_t stride;
+		size_t len;
+		if (!hdr_load(r, p, h, &stride, &len)) {
+			if (used > 0) break;	// дірка — тільки перед поверненим (див. log_ring.h)
+			reader_reset(r, reset);
+			p = ring_seek(r, p + LOG_RING_ALIGN, head);
+			continue;
+		}
+
+		size_t pre = 0;
+		bool deferred = h->deferred;
+		uint32_t ts = h->ts;
+		uint16_t ms = h->ms;
+		uint8_t lvl = h->level;
+		uint8_t raw[LOG_DEFER_MAX];
+
+		if (deferred) {
+			// аргументи — в копію; рендер тільки після перевірки, що їх не переписали
+			if (len > sizeof(raw) || !level_match(lvl, flt)) len = 0;
+			if (len > 0) {
+				if (used + LOG_RING_TEXT_PREFIX_MAX + LOG_RING_LINE_MAX + 1 > cap) break;
+				memcpy(raw, (const char *)(h + 1), len);
+			}
+		} else {
+			// відфільтровані — як pad: тільки йдемо далі (якщо запис не переписали посеред перевірки)
+			if (len > 0 && !rec_match(h, len, flt)) len = 0;
+
+			// порожні записи (pad) не віддаємо
+			if (len > 0) {
+				if (fmt == LOG_RING_FMT_BIN) {
+					if (used + LOG_RING_BIN_HDR + len > cap) break;
+					bin_hdr(out + used, p, ts, ms, lvl, len);
+					pre = LOG_RING_BIN_HDR;
+				} else {
+					if (used + LOG_RING_TEXT_PREFIX_MAX + len + 1 > cap) break;
+					pre = text_prefix(&tsp, ts, ms, out + used);
+				}
+				memcpy(out + used + pre, (const char *)(h + 1), len);
+			}
+		}
+
+		if (rec_overwritten(r, p, &head)) {
+			// вже скопійоване віддаємо; наступний виклик почне з p — і отримає reset
+			if (used > 0) break;
+			reader_reset(r, reset);
+			p = ring_seek(r, ring_lower(r, head), head);
+			continue;
+		}
+
+		if (deferred && len > 0) {
+			char *b = out + used;
+			pre = (fmt == LOG_RING_FMT_BIN) ? LOG_RING_BIN_HDR : text_prefix(&tsp, ts, ms, b);
+			len = deferred_render(raw, len, lvl, b + pre, flt);
+			if (len > 0 && fmt == LOG_RING_FMT_BIN) bin_hdr(b, p, ts, ms, lvl, len);
+		}
+
+		if (len > 0) {
+			used += pre + len;
+			if (fmt == LOG_RING_FMT_TEXT) out[used++] = '\n';
+		}
+		p += stride;
+	}
+
+	*cursor = p;
+	return used;
+}
+
+size_t log_ring_read_to(log_ring_t *r, uint32_t *cursor, uint32_t end, char *out, size_t cap, bool *reset)
+{
+	return log_ring_read_fmt(r, cursor, end, out, cap, reset, LOG_RING_FMT_TEXT, NULL);
+}
+
+bool log_ring_skip(log_ring_t *r, uint32_t *cursor, const log_ring_filter_t *flt, bool *reset,
+		   log_ring_scratch_t *tmp)
+{
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	uint32_t p = ring_start(r, *cursor, ring_lower(r, head), head, reset);
+	bool found = false;
+
+	while ((int32_t)(head - p) > 0) {
+		uint32_t q = skip_tail(r, p);
+		if (q != p) {
+			p = q;
+			continue;
+		}
+
+		const log_rec_hdr_t *h = rec_at(r, p);
+		uint32_t stride;
+		size_t len;
+		if (atomic_load_explicit(&h->pos, memory_order_acquire) != p || !hdr_load(r, p, h, &stride, &len)) break;
+
+		bool deferred = h->deferred;
+		uint8_t lvl = h->level;
+		bool render = deferred && tmp && filter_needs_text(flt);
+		bool match = false;
+
+		if (len == 0) {
+			match = false;
+		} else if (!deferred) {
+			match = rec_match(h, len, flt);
+		} else if (len <= LOG_DEFER_MAX && level_match(lvl, flt)) {
+			// рівень є в заголовку; текст рендеримо тільки під tag/пошук
+			match = true;
+			if (render) memcpy(tmp->raw, (const char *)(h + 1), len);
+		}
+
+		if (rec_overwritten(r, p, &head)) {
+			reader_reset(r, reset);
+			p = ring_seek(r, ring_lower(r, head), head);
+			continue;
+		}
+
+		if (match && render) {
+			match = deferred_render(tmp->raw, len, lvl, tmp->txt, flt) > 0;
+		}
+		if (match) {
+			found = true;
+			break;
+		}
+		p += stride;
+	}
+
+	*cursor = p;
+	return found;
+}
+
+size_t log_ring_read(log_ring_t *r, uint32_t *cursor, char *out, size_t cap, bool *reset)
+{
+	return log_ring_read_to(r, cursor, log_ring_next(r), out, cap, reset);
+}
+
+void log_ring_get_stats(log_ring_t *r, log_ring_stats_t *st)
+{
+	uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	uint32_t lower = ring_lower(r, head);
+
+	memset(st, 0, sizeof(*st));
+	st->size = r->size;
+	st->used = head - lower;	// == log_ring_used() для того ж head
+	st->appends = atomic_load_explicit(&r->appends, memory_order_relaxed);
+	st->truncated = atomic_load_explicit(&r->truncated, memory_order_relaxed);
+	st->lapped = atomic_load_explicit(&r->lapped, memory_order_relaxed);
+	st->bytes = atomic_load_explicit(&r->bytes, memory_order_relaxed);
+	st->deferred = atomic_load_explicit(&r->deferred, memory_order_relaxed);
+	st->resets = atomic_load_explicit(&r->resets, memory_order_relaxed);
+
+	// рядки рахуємо проходом по заголовках (тільки для статистики)
+	uint32_t p = ring_seek(r, lower, head);
+	while ((int32_t)(head - p) > 0) {
+		uint32_t q = skip_tail(r, p);
+		if (q != p) {
+			p = q;
+			continue;
+		}
+
+		const log_rec_hdr_t *h = rec_at(r, p);
+		if (atomic_load_explicit(&h->pos, memory_order_acquire) != p || !hdr_sane(r, p, h)) break;
+		if (h->len > 0) st->lines++;
+		p += h->stride;
+	}
+}
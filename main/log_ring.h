@@ -0,0 +1,208 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "log_defer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Кільцевий лог у вигляді "арени" байтів:
+	- кожен запис = заголовок log_rec_hdr_t (з часом і рівнем) + текст (без '\0'), вирівняно на 8
+	- або замість тексту — запакований fmt + аргументи (log_defer.h), текст рендериться при читанні
+	- cursor = абсолютна байтова позиція запису (монотонна, u32 з переповненням)
+	- writer-и не беруть lock: резерв через CAS на head, публікація через штамп pos
+*/
+
+#ifndef LOG_RING_LINE_MAX
+	#define LOG_RING_LINE_MAX		1024	// максимум тексту в одному записі
+#endif
+
+#define LOG_RING_ALIGN			8
+#define LOG_RING_ALIGN_UP(x)		(((x) + (LOG_RING_ALIGN - 1)) & ~(uint32_t)(LOG_RING_ALIGN - 1))
+
+// Рівні як у esp_log_level_t (0 = невідомий)
+#define LOG_RING_LVL_NONE		0
+#define LOG_RING_LVL_E			1
+#define LOG_RING_LVL_W			2
+#define LOG_RING_LVL_I			3
+#define LOG_RING_LVL_D			4
+#define LOG_RING_LVL_V			5
+
+#ifndef LOG_RING_TAG_MAX
+	#define LOG_RING_TAG_MAX		32	// довший tag не індексується (tag_len = 0)
+#endif
+
+#ifndef LOG_RING_FIND_MAX
+	#define LOG_RING_FIND_MAX		48	// підрядок для пошуку
+#endif
+
+// Метадані запису (задає writer у commit)
+typedef struct {
+	uint32_t		ts;		// unix секунди (0 = час ще не синхронізований)
+	uint16_t		ms;
+	uint8_t			level;		// LOG_RING_LVL_*
+	uint8_t			tag_off;	// tag ("wifi" у "I (12) wifi: ...") = text[tag_off .. +tag_len)
+	uint8_t			tag_len;	// 0 — tag не знайдено
+	bool			deferred;	// замість тексту — log_defer_pack (tag тоді шукається при читанні)
+} log_rec_meta_t;
+
+typedef struct {
+	_Atomic uint32_t	pos;		// == позиції запису коли опубліковано; pos|1 — ще пишеться
+	uint16_t		stride;		// скільки байт займає запис разом із заголовком (кратно 8)
+	uint16_t		len;		// довжина тексту або запакованих аргументів (0 = pad / порожній рядок)
+	uint32_t		ts;
+	uint16_t		ms	: 10;
+	uint16_t		level	: 3;
+	uint16_t		deferred: 1;
+	uint16_t		rsv	: 2;
+	uint8_t			tag_off;
+	uint8_t			tag_len;
+} log_rec_hdr_t;
+
+/*
+	Фільтр читання (перевіряється на root по метаданих, до копіювання тексту).
+	Відфільтровані записи просто пропускаються — cursor все одно йде вперед.
+*/
+typedef struct {
+	uint8_t			max_level;	// 0 — всі; інакше тільки записи з рівнем 1..max_level
+	uint8_t			tag_len;	// 0 — будь-який tag
+	uint8_t			find_len;	// 0 — без пошуку підрядка
+	char			tag[LOG_RING_TAG_MAX];
+	char			find[LOG_RING_FIND_MAX];
+} log_ring_filter_t;
+
+/*
+	Формати читання:
+	TEXT — "[YYYY-MM-DD HH:MM:SS.mmm] текст\n" (префікс часу рендериться при читанні)
+	BIN  — на кожен запис LOG_RING_BIN_HDR байт little-endian + текст без '\0':
+	       u32 cursor (позиція запису), u32 ts, u16 ms, u8 level, u8 0, u16 len
+*/
+typedef enum {
+	LOG_RING_FMT_TEXT = 0,
+	LOG_RING_FMT_BIN,
+} log_ring_fmt_t;
+
+#define LOG_RING_BIN_HDR		14
+#define LOG_RING_TEXT_PREFIX_MAX	32	// "[YYYY-MM-DD HH:MM:SS.mmm] " з запасом
+
+typedef struct {
+	uint8_t			*buf;
+	uint32_t		size;		// степінь двійки, >= 2 * максимального запису
+	_Atomic uint32_t	head;		// кінець останнього резерву (абсолютна позиція)
+	_Atomic uint32_t	floor;		// все що нижче — очищено (/clear)
+
+	// лічильники (для підбору розміру під плату)
+	_Atomic uint32_t	appends;
+	_Atomic uint32_t	truncated;	// обрізані до LOG_RING_LINE_MAX
+	_Atomic uint32_t	lapped;		// відкинуті: writer-а обігнали між reserve і commit
+	_Atomic uint32_t	bytes;
+	_Atomic uint32_t	deferred;	// з них записано без форматування
+	_Atomic uint32_t	resets;		// читачам віддано reset (ring обігнав, /clear)
+} log_ring_t;
+
+// Резерв під один запис (заповнює log_ring_reserve, віддається в log_ring_commit)
+typedef struct {
+	uint32_t		pos;
+	uint32_t		need;
+	size_t			cap;		// скільки байт тексту можна писати (разом із '\0' від vsnprintf)
+} log_ring_wr_t;
+
+typedef struct {
+	uint32_t		size;
+	uint32_t		used;		// байт у вікні [earliest, head)
+	uint32_t		lines;		// рядків у вікні (рахується проходом)
+	uint32_t		appends;
+	uint32_t		truncated;
+	uint32_t		lapped;
+	uint32_t		bytes;
+	uint32_t		deferred;
+	uint32_t		resets;
+} log_ring_stats_t;
+
+// buf має бути вирівняний на 8, size — степінь двійки
+void		log_ring_init(log_ring_t *r, void *buf, uint32_t size);
+void		log_ring_clear(log_ring_t *r);
+
+// Writer: резерв -> пишемо текст у повернутий вказівник -> commit з фактичною довжиною
+char		*log_ring_reserve(log_ring_t *r, size_t max_len, log_ring_wr_t *wr);
+void		log_ring_commit(log_ring_t *r, const log_ring_wr_t *wr, size_t len, const log_rec_meta_t *meta);
+
+// Резерв + memcpy + commit (для готових рядків, напр. з mesh)
+void		log_ring_append(log_ring_t *r, const char *line, size_t len, const log_rec_meta_t *meta);
+
+/*
+	Рівень і tag з рядка ESP-IDF: "I (1234) TAG: ...", можливо після ANSI кольору
+	і з часом від log_time_vprintf ноди: "I (1234) [2025-01-01 12:00:00] TAG: ...".
+	Заповнює level, tag_off, tag_len.
+*/
+void		log_ring_parse_line(const char *s, size_t len, log_rec_meta_t *m);
+
+// 'E'/'W'/'I'/'D'/'V' -> LOG_RING_LVL_*, інше -> LOG_RING_LVL_NONE
+uint8_t		log_ring_level_of(char c);
+
+// Позиція, з якої почнеться наступний запис
+uint32_t	log_ring_next(const log_ring_t *r);
+
+// Скільки байт арени зараз зайнято видимою історією
+uint32_t	log_ring_used(const log_ring_t *r);
+
+/*
+	Reader: копіює в out цілі рядки (кожен + '\n') починаючи з *cursor, поки влазить у cap.
+	cap має бути > LOG_RING_LINE_MAX + LOG_RING_TEXT_PREFIX_MAX, інакше довгий рядок ніколи не влізе.
+	*cursor зсувається за останній скопійований запис; якщо cursor вже випав з вікна
+	(або невалідний) — *reset = true і читаємо з найранішого.
+	*reset = true завжди означає дірку ПЕРЕД поверненими рядками: якщо writer-и обігнали читача
+	посеред виклику, вже скопійоване повертається без reset, а дірку побачить наступний виклик.
+*/
+size_t		log_ring_read(log_ring_t *r, uint32_t *cursor, char *out, size_t cap, bool *reset);
+
+// Те саме, але не далі за end (для відповіді шматками до заздалегідь відомого X-Log-Next)
+size_t		log_ring_read_to(log_ring_t *r, uint32_t *cursor, uint32_t end, char *out, size_t cap, bool *reset);
+
+// Те саме у вибраному форматі і тільки записи, що проходять фільтр (flt == NULL — всі)
+size_t		log_ring_read_fmt(log_ring_t *r, uint32_t *cursor, uint32_t end, char *out, size_t cap,
+				bool *reset, log_ring_fmt_t fmt, const log_ring_filter_t *flt);
+
+/*
+	Префікс одного запису у форматі читання — для записів не з ring (напр. історія з flash):
+	BIN — LOG_RING_BIN_HDR байт, TEXT — "[час] ". Текст і '\n' (для TEXT) дописує caller.
+*/
+size_t		log_ring_fmt_prefix(log_ring_fmt_t fmt, uint32_t pos, const log_rec_meta_t *m, size_t len, char *out);
+
+// Місце під рендер відкладеного запису (~1.2 КБ) — не на стеку, у caller-а свій на таску
+typedef struct {
+	uint8_t		raw[LOG_DEFER_MAX];
+	char		txt[LOG_RING_LINE_MAX + 1];
+} log_ring_scratch_t;
+
+/*
+	Пропустити записи, що не проходять фільтр: *cursor зупиняється на першому, що проходить
+	(тоді true), або на межі опублікованих. Для long-poll з фільтром: "є нове" = є що віддати.
+	tmp потрібен тільки для відкладених записів під фільтр tag/пошуку; NULL — такі вважаються
+	такими, що проходять (зайва відповідь, але без рендеру).
+*/
+bool		log_ring_skip(log_ring_t *r, uint32_t *cursor, const log_ring_filter_t *flt, bool *reset,
+			      log_ring_scratch_t *tmp);
+
+static inline bool log_ring_filter_empty(const log_ring_filter_t *flt)
+{
+	return !flt || (flt->max_level == 0 && flt->tag_len == 0 && flt->find_len == 0);
+}
+
+/*
+	Нормалізує *cursor (як log_ring_read) і повертає межу опублікованих записів:
+	все в [*cursor, frontier) можна читати. Текст не копіюється.
+*/
+uint32_t	log_ring_frontier(log_ring_t *r, uint32_t *cursor, bool *reset);
+
+void		log_ring_get_stats(log_ring_t *r, log_ring_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
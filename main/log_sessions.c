@@ -0,0 +1,231 @@
+#include "log_sessions.h"
+
+#include <string.h>
+
+#include "esp_random.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+typedef struct {
+	uint32_t	id;		// 0 — слот вільний
+	uint8_t		mac[6];
+	char		tag[16];
+	uint32_t	last_seen_ms;
+	uint16_t	holds;		// відкритих WebSocket
+} sess_t;
+
+static sess_t s_sess[LOG_SESSIONS_MAX];
+static SemaphoreHandle_t s_mtx = NULL;
+static uint8_t s_local_mac[6];
+static char s_local_tag[16];
+static log_sessions_view_cb_t s_on_view = NULL;
+
+static uint32_t ms_now(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+// рекурсивний: on_view може витіснити ring, а колбек витіснення питає log_sessions_viewers()
+static void lock(void)
+{
+	xSemaphoreTakeRecursive(s_mtx, portMAX_DELAY);
+}
+
+static void unlock(void)
+{
+	xSemaphoreGiveRecursive(s_mtx);
+}
+
+// під mutex
+static sess_t *find(uint32_t id)
+{
+	if (id == 0) return NULL;
+
+	for (int i = 0; i < LOG_SESSIONS_MAX; i++) {
+		if (s_sess[i].id == id) return &s_sess[i];
+	}
+	return NULL;
+}
+
+// під mutex
+static uint16_t count_viewers(const uint8_t mac[6])
+{
+	uint16_t n = 0;
+
+	for (int i = 0; i < LOG_SESSIONS_MAX; i++) {
+		if (s_sess[i].id && memcmp(s_sess[i].mac, mac, 6) == 0) n++;
+	}
+	return n;
+}
+
+// під mutex: сесія вже змінена, повідомляємо з новою кількістю глядачів
+static void notify(const uint8_t mac[6], int delta)
+{
+	if (s_on_view) s_on_view(mac, delta, count_viewers(mac));
+}
+
+// під mutex
+static void drop(sess_t *s)
+{
+	uint8_t mac[6];
+	memcpy(mac, s->mac, 6);
+
+	memset(s, 0, sizeof(*s));
+	notify(mac, -1);
+}
+
+static uint32_t new_id(void)
+{
+	for (;;) {
+		uint32_t id = esp_random();
+		if (id != 0 && !find(id)) return id;
+	}
+}
+
+void log_sessions_init(const uint8_t local_mac[6], const char *local_tag, log_sessions_view_cb_t on_view)
+{
+	if (!s_mtx) s_mtx = xSemaphoreCreateRecursiveMutex();
+
+	memcpy(s_local_mac, local_mac, 6);
+	strncpy(s_local_tag, local_tag ? local_tag : "node", sizeof(s_local_tag) - 1);
+	s_local_tag[sizeof(s_local_tag) - 1] = '\0';
+	s_on_view = on_view;
+}
+
+bool log_sessions_touch(uint32_t id)
+{
+	lock();
+	sess_t *s = find(id);
+	if (s) s->last_seen_ms = ms_now();
+	unlock();
+
+	return s != NULL;
+}
+
+void log_sessions_get(uint32_t id, uint8_t mac[6], char *tag, size_t tag_cap)
+{
+	lock();
+	sess_t *s = find(id);
+	memcpy(mac, s ? s->mac : s_local_mac, 6);
+	if (tag && tag_cap > 0) {
+		strncpy(tag, s ? s->tag : s_local_tag, tag_cap - 1);
+		tag[tag_cap - 1] = '\0';
+	}
+	unlock();
+}
+
+uint32_t log_sessions_select(uint32_t id, const uint8_t mac[6], const char *tag, bool *created)
+{
+	if (created) *created = false;
+
+	lock();
+
+	sess_t *s = find(id);
+	if (!s) {
+		// вільний слот, інакше — найдовше неактивна без WebSocket
+		uint32_t now = ms_now();
+		sess_t *victim = NULL;
+
+		for (int i = 0; i < LOG_SESSIONS_MAX; i++) {
+			sess_t *c = &s_sess[i];
+			if (c->id == 0) {
+				s = c;
+				break;
+			}
+			if (c->holds > 0) continue;
+			if (!victim || (now - c->last_seen_ms) > (now - victim->last_seen_ms)) victim = c;
+		}
+		if (!s && victim) {
+			drop(victim);
+			s = victim;
+		}
+		if (!s) {
+			unlock();
+			return 0;
+		}
+
+		// нова сесія спершу дивиться local (як і без сесії), далі — звичайна зміна вибору
+		s->id = new_id();
+		memcpy(s->mac, s_local_mac, 6);
+		strncpy(s->tag, s_local_tag, sizeof(s->tag) - 1);
+		s->holds = 0;
+		notify(s->mac, +1);
+		if (created) *created = true;
+	}
+
+	s->last_seen_ms = ms_now();
+	if (tag && tag[0]) {
+		strncpy(s->tag, tag, sizeof(s->tag) - 1);
+		s->tag[sizeof(s->tag) - 1] = '\0';
+	}
+
+	if (memcmp(s->mac, mac, 6) != 0) {
+		uint8_t old[6];
+		memcpy(old, s->mac, 6);
+		memcpy(s->mac, mac, 6);
+
+		// сесія вже дивиться нову ноду, стара втратила глядача
+		notify(mac, +1);
+		notify(old, -1);
+	}
+
+	id = s->id;
+	unlock();
+	return id;
+}
+
+void log_sessions_hold(uint32_t id, int delta)
+{
+	lock();
+	sess_t *s = find(id);
+	if (s) {
+		if (delta < 0 && s->holds < (uint16_t)(-delta)) {
+			s->holds = 0;
+		} else {
+			s->holds = (uint16_t)(s->holds + delta);
+		}
+		s->last_seen_ms = ms_now();
+	}
+	unlock();
+}
+
+uint32_t log_sessions_expire(uint32_t max_idle_ms)
+{
+	uint32_t now = ms_now();
+	uint32_t n = 0;
+
+	lock();
+	for (int i = 0; i < LOG_SESSIONS_MAX; i++) {
+		sess_t *s = &s_sess[i];
+		if (s->id == 0 || s->holds > 0) continue;
+		if ((now - s->last_seen_ms) <= max_idle_ms) continue;
+
+		drop(s);
+		n++;
+	}
+	unlock();
+
+	return n;
+}
+
+uint16_t log_sessions_viewers(const uint8_t mac[6])
+{
+	lock();
+	uint16_t n = count_viewers(mac);
+	unlock();
+	return n;
+}
+
+uint32_t log_sessions_count(void)
+{
+	uint32_t n = 0;
+
+	lock();
+	for (int i = 0; i < LOG_SESSIONS_MAX; i++) {
+		if (s_sess[i].id) n++;
+	}
+	unlock();
+	return n;
+}
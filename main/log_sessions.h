@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Сесії дашборда: у кожного браузера (cookie LOG_SESSIONS_COOKIE) свій вибраний ring,
+	тож кілька операторів дивляться різні ноди і не перемикають одне одному.
+	- без сесії (або з cookie попереднього boot) клієнт бачить local ноду
+	- глядачі ноди = сесії, що її вибрали; on_view викликається на кожну зміну з новою кількістю,
+	  тож стрім вмикається на першого глядача і вимикається на останнього
+	- сесія без запитів довше за LOG_SESSIONS_IDLE_MS прибирається (якщо не тримає WebSocket)
+*/
+
+#ifndef LOG_SESSIONS_MAX
+	#define LOG_SESSIONS_MAX		8
+#endif
+
+#ifndef LOG_SESSIONS_IDLE_MS
+	#define LOG_SESSIONS_IDLE_MS		(2 * 60 * 1000)	// > web/index.html: WAIT_MS і період /nodes
+#endif
+
+#define LOG_SESSIONS_COOKIE		"logsid"
+
+// Під mutex сесій (порядок викликів = порядок змін). delta = +1 / -1, viewers — вже після зміни.
+typedef void (*log_sessions_view_cb_t)(const uint8_t mac[6], int delta, uint16_t viewers);
+
+void		log_sessions_init(const uint8_t local_mac[6], const char *local_tag, log_sessions_view_cb_t on_view);
+
+// Сесія є (і тепер вважається активною). false — невідомий id.
+bool		log_sessions_touch(uint32_t id);
+
+// Вибір сесії; для невідомої — local нода
+void		log_sessions_get(uint32_t id, uint8_t mac[6], char *tag, size_t tag_cap);
+
+/*
+	Змінити вибір сесії. id невідомий (0, з попереднього boot, витіснений) — створюється нова,
+	при нестачі місця витісняється найдовше неактивна без WebSocket.
+	Повертає id сесії (0 — місця нема) і *created.
+*/
+uint32_t	log_sessions_select(uint32_t id, const uint8_t mac[6], const char *tag, bool *created);
+
+// WebSocket тримає сесію від витіснення за неактивністю (delta = +1 / -1)
+void		log_sessions_hold(uint32_t id, int delta);
+
+// Прибрати неактивні. Повертає скільки прибрано.
+uint32_t	log_sessions_expire(uint32_t max_idle_ms);
+
+uint16_t	log_sessions_viewers(const uint8_t mac[6]);
+uint32_t	log_sessions_count(void);
+
+#ifdef __cplusplus
+}
+#endif
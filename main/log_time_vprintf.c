@@ -1,4 +1,5 @@
 #include "log_time_vprintf.h"
+#include "log_clock.h"
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -25,29 +26,6 @@ extern vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
 static bool s_started = false;
 static bool s_enabled = true;
 
-static bool get_local_time_str(char *out, size_t out_sz)
-{
-	if (out_sz < 20) {
-		return false;
-	}
-
-	time_t now = 0;
-	struct tm tm_now;
-
-	time(&now);
-	localtime_r(&now, &tm_now);
-
-	// якщо час ще не синхронізований (приблизно 1970) — не вставляємо
-	if (tm_now.tm_year < (2020 - 1900)) {
-		return false;
-	}
-
-	// "YYYY-MM-DD HH:MM:SS" => 19 символів + '\0'
-	size_t n = strftime(out, out_sz, "%Y-%m-%d %H:%M:%S", &tm_now);
-	return (n > 0);
-}
-
-
 static bool is_log_line_start(char c0, char c1)
 {
 	// Формат ESP-IDF: "I (1234) TAG: ..."
@@ -60,7 +38,6 @@ static bool is_log_line_start(char c0, char c1)
 static int log_time_vprintf(const char *fmt, va_list ap)
 {
 	char orig[256];
-	char out[320];
 	char ts[32];
 
 	va_list ap2;
@@ -70,40 +47,54 @@ static int log_time_vprintf(const char *fmt, va_list ap)
 
 	orig[sizeof(orig) - 1] = '\0';
 
+	// "YYYY-MM-DD HH:MM:SS.mmm" з кешу секунди; без синхронізованого часу — не вставляємо
 	bool have_ts = false;
 	if (s_enabled) {
-		have_ts = get_local_time_str(ts, sizeof(ts));
+		have_ts = log_clock_stamp(ts, sizeof(ts)) > 0;
 	}
 
+	// Пишемо напряму в stdout (UART) шматками — без другого проходу форматування.
+	// Не використовуємо ESP_LOG всередині хука!
+	size_t len = strlen(orig);
+	size_t out_len = len;
+
+	// шматки одного рядка не мають перемежовуватись з іншими задачами
+	flockfile(stdout);
+
 	if (s_enabled && have_ts && is_log_line_start(orig[0], orig[1])) {
 		// Спроба вставити час після ") " щоб зберегти колір (рядок все ще починається з 'I')
 		char *p = strchr(orig, ')');
 		if (p && p[1] == ' ') {
-			int head_len = (int)((p - orig) + 2); // включно ") "
-			snprintf(out, sizeof(out),
-				"%.*s[%s] %s",
-				head_len, orig,
-				ts,
-				orig + head_len
-			);
+			size_t head_len = (size_t)(p - orig) + 2; // включно ") "
+			fwrite(orig, 1, head_len, stdout);
+			fputc('[', stdout);
+			fputs(ts, stdout);
+			fputs("] ", stdout);
+			fwrite(orig + head_len, 1, len - head_len, stdout);
 		} else {
 			// fallback (дуже рідко)
-			snprintf(out, sizeof(out), "%s [%s]", orig, ts);
+			fwrite(orig, 1, len, stdout);
+			fputs(" [", stdout);
+			fputs(ts, stdout);
+			fputc(']', stdout);
 		}
+		out_len += strlen(ts) + 3;
 	} else if (s_enabled && have_ts) {
 		// Якщо це не “класичний” log-рядок — просто дописуємо час на початок
-		snprintf(out, sizeof(out), "[%s] %s", ts, orig);
+		fputc('[', stdout);
+		fputs(ts, stdout);
+		fputs("] ", stdout);
+		fwrite(orig, 1, len, stdout);
+		out_len += strlen(ts) + 3;
 	} else {
 		// Без часу
-		strncpy(out, orig, sizeof(out));
-		out[sizeof(out) - 1] = '\0';
+		fwrite(orig, 1, len, stdout);
 	}
 
-	// Пишемо напряму в stdout (UART). Не використовуємо ESP_LOG всередині хука!
-	fputs(out, stdout);
+	funlockfile(stdout);
 
 	// Повертаємо “щось” (не критично)
-	return (int)strlen(out);
+	return (int)out_len;
 }
 
 esp_err_t log_time_vprintf_start(void)
@@ -0,0 +1,458 @@
+#include "mesh_log_stream.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "esp_mesh.h"
+#include "esp_wifi.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "mesh_proto.h"
+#include "log_dict.h"
+#include "log_ring.h"
+
+static const char *TAG = "mesh_log";
+
+typedef struct {
+	char	line[sizeof(((mesh_log_line_packet_t *)0)->line)];
+} stream_item_t;
+
+static QueueHandle_t s_q = NULL;
+static TaskHandle_t s_task = NULL;
+static vprintf_like_t s_orig_vprintf = NULL;
+static char s_tag[sizeof(((mesh_nodeinfo_packet_t *)0)->tag)];
+static uint8_t s_tag_id = 0;
+static volatile bool s_announce = false;	// NODEINFO поза чергою (новий root / він просить)
+
+static volatile bool s_enabled = false;
+static volatile uint16_t s_rate_lps = 0;
+static volatile uint16_t s_rate_burst = MESH_LOG_RATE_BURST;
+
+// token bucket (у тисячних рядка, як node_dir на root)
+static portMUX_TYPE s_rate_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_tokens = 0;
+static uint32_t s_refill_ms = 0;
+
+// фільтр з CTRL: hook читає під s_flt_lock (CTRL приходить з mesh_rx_task)
+static portMUX_TYPE s_flt_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t s_flt_level = 0;
+static volatile uint8_t s_flt_mode = MESH_LOG_CTRL_TAGS_NONE;
+static char s_flt_tags[sizeof(((mesh_log_ctrl_packet_t *)0)->tags)];
+
+// тільки для звіту в UART (див. mesh_log_stream_task); root бачить ці втрати як "lines lost"
+static _Atomic uint32_t s_dropped_full = 0;
+static _Atomic uint32_t s_dropped_rate = 0;
+
+static uint32_t s_seq = 0;	// тільки таска
+static _Atomic uint32_t s_skipped = 0;	// відкинуто hook-ом з останнього рядка, що дійшов до таски
+
+static uint32_t ms_now(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static bool rate_admit(void)
+{
+	uint16_t lps = s_rate_lps;
+	if (lps == 0) return true;
+
+	bool ok = false;
+
+	portENTER_CRITICAL(&s_rate_lock);
+	{
+		const uint32_t cap = (uint32_t)s_rate_burst * 1000u;
+		uint32_t now = ms_now();
+		uint32_t dt = now - s_refill_ms;
+		s_refill_ms = now;
+
+		uint64_t t = (uint64_t)s_tokens + (uint64_t)dt * lps;
+		s_tokens = (t > cap) ? cap : (uint32_t)t;
+
+		if (s_tokens >= 1000) {
+			s_tokens -= 1000;
+			ok = true;
+		}
+	}
+	portEXIT_CRITICAL(&s_rate_lock);
+
+	return ok;
+}
+
+// tag (len байт, без '\0') є у списку "a,b,c"
+static bool tag_listed(const char *list, const char *tag, size_t len)
+{
+	for (const char *p = list; *p; ) {
+		const char *e = strchr(p, ',');
+		size_t n = e ? (size_t)(e - p) : strlen(p);
+
+		if (n == len && memcmp(p, tag, len) == 0) return true;
+		if (!e) break;
+		p = e + 1;
+	}
+	return false;
+}
+
+// Рівень і tag — так само, як їх потім розбере root (log_ring_parse_line)
+static bool filter_pass(const char *line, size_t len)
+{
+	if (s_flt_level == 0 && s_flt_mode == MESH_LOG_CTRL_TAGS_NONE) return true;
+
+	log_rec_meta_t m;
+	log_ring_parse_line(line, len, &m);
+
+	bool ok = true;
+	portENTER_CRITICAL(&s_flt_lock);
+	{
+		// рядок без рівня (printf, продовження) — як ?level= у /log: не проходить
+		if (s_flt_level && (m.level == LOG_RING_LVL_NONE || m.level > s_flt_level)) {
+			ok = false;
+		} else if (s_flt_mode != MESH_LOG_CTRL_TAGS_NONE) {
+			bool listed = m.tag_len && tag_listed(s_flt_tags, line + m.tag_off, m.tag_len);
+			ok = (s_flt_mode == MESH_LOG_CTRL_TAGS_INCLUDE) ? listed : !listed;
+		}
+	}
+	portEXIT_CRITICAL(&s_flt_lock);
+
+	return ok;
+}
+
+static size_t trim_eol(const char *s, size_t len)
+{
+	while (len > 0 && (s[len - 1] == '\n' || s[len - 1] == '\r')) len--;
+	return len;
+}
+
+static int mesh_log_vprintf(const char *fmt, va_list ap)
+{
+	int ret = 0;
+
+	if (s_orig_vprintf) {
+		va_list ap_copy;
+		va_copy(ap_copy, ap);
+		ret = s_orig_vprintf(fmt, ap_copy);
+		va_end(ap_copy);
+	}
+
+	// рядки самої таски (і mesh/wifi стеку з її контексту) не шлемо — інакше петля
+	if (!s_enabled || !s_q || xTaskGetCurrentTaskHandle() == s_task) return ret;
+	if (esp_mesh_is_root()) return ret;
+
+	stream_item_t it;
+	va_list ap_copy2;
+	va_copy(ap_copy2, ap);
+	int w = vsnprintf(it.line, sizeof(it.line), fmt, ap_copy2);
+	va_end(ap_copy2);
+
+	if (w <= 0) return ret;
+	size_t len = ((size_t)w < sizeof(it.line)) ? (size_t)w : sizeof(it.line) - 1;
+	len = trim_eol(it.line, len);
+	if (len == 0) return ret;
+	it.line[len] = '\0';
+
+	// відфільтроване root не просив: не займає ні токен, ні номер рядка
+	if (!filter_pass(it.line, len)) return ret;
+
+	if (!rate_admit()) {
+		atomic_fetch_add_explicit(&s_dropped_rate, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&s_skipped, 1, memory_order_relaxed);
+		return ret;
+	}
+
+	if (xQueueSend(s_q, &it, 0) != pdTRUE) {
+		atomic_fetch_add_explicit(&s_dropped_full, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&s_skipped, 1, memory_order_relaxed);
+	}
+	return ret;
+}
+
+static void hdr_fill(mesh_pkt_hdr_t *h, uint8_t type, uint32_t counter)
+{
+	h->magic = MESH_PKT_MAGIC;
+	h->version = MESH_PKT_VERSION;
+	h->type = type;
+	h->counter = counter;
+	esp_wifi_get_mac(WIFI_IF_STA, h->src_mac);
+}
+
+// 00:00:00:00:00:00 => root
+static esp_err_t send_to_root(const void *pkt, size_t len)
+{
+	mesh_addr_t dest;
+	memset(&dest, 0, sizeof(dest));
+
+	mesh_data_t data;
+	memset(&data, 0, sizeof(data));
+	data.data = (uint8_t *)pkt;
+	data.size = len;
+	data.proto = MESH_PROTO_BIN;
+	data.tos = MESH_TOS_P2P;
+
+	return esp_mesh_send(&dest, &data, MESH_DATA_P2P, NULL, 0);
+}
+
+static void send_nodeinfo(void)
+{
+	mesh_nodeinfo_packet_t p;
+	memset(&p, 0, sizeof(p));
+	hdr_fill(&p.h, MESH_LOG_TYPE_NODEINFO, ms_now());
+	memcpy(p.tag, s_tag, sizeof(p.tag));
+	p.tag_id = s_tag_id;
+
+	send_to_root(&p, sizeof(p));
+}
+
+/*
+	Пачка рядків (mesh_log_batch_packet_t) — тільки з таски. Шлеться, коли наступний рядок
+	не влазить або перший рядок чекає довше за MESH_LOG_STREAM_FLUSH_MS.
+*/
+static union {
+	mesh_log_batch_packet_t	p;
+	uint8_t			raw[MESH_PKT_MAX];
+} s_batch;
+static size_t s_batch_used = 0;		// байт у s_batch.p.data
+
+#if MESH_LOG_STREAM_DICT
+// історія log_dict: на root така сама, поки доходять усі пачки; інакше — keyframe
+static log_dict_enc_t s_enc;
+static volatile bool s_key_due = true;
+static uint32_t s_since_key = 0;
+#endif
+
+static void batch_reset(void)
+{
+	s_batch.p.count = 0;
+	s_batch.p.flags = 0;
+	s_batch_used = 0;
+}
+
+static void batch_flush(void)
+{
+	uint8_t n = s_batch.p.count;
+	if (n == 0) return;
+
+	hdr_fill(&s_batch.p.h, MESH_LOG_TYPE_BATCH, s_seq + 1);
+	s_batch.p.tag_id = s_tag_id;
+	s_seq += n;	// втрачена пачка лишає дірку в нумерації h.counter
+
+	esp_err_t err = send_to_root(&s_batch.p, sizeof(s_batch.p) + s_batch_used);
+
+#if MESH_LOG_STREAM_DICT
+	// root цієї пачки не має — наступна з чистою історією; і періодично, на випадок тихих втрат
+	if (err != ESP_OK || ++s_since_key >= MESH_LOG_STREAM_KEY_EVERY) s_key_due = true;
+#else
+	(void)err;
+#endif
+	batch_reset();
+}
+
+static void batch_drop(void)
+{
+#if MESH_LOG_STREAM_DICT
+	if (s_batch.p.count > 0) s_key_due = true;	// ці рядки вже в історії кодера
+#endif
+	batch_reset();
+}
+
+/*
+	Рядки, відкинуті hook-ом (черга повна / rate_lps), теж отримують номери — root бачить їх
+	як дірку і пише "N lines lost", тож насичення видно там, де дивляться лог.
+*/
+static void batch_skip(void)
+{
+	uint32_t skip = atomic_exchange_explicit(&s_skipped, 0, memory_order_relaxed);
+	if (skip == 0) return;
+
+	batch_flush();
+	s_seq += skip;
+#if MESH_LOG_STREAM_DICT
+	s_key_due = true;	// root перевіряє неперервність історії за номерами
+#endif
+}
+
+static void batch_add(const char *line)
+{
+	size_t len = strnlen(line, sizeof(((stream_item_t *)0)->line));
+	uint8_t rec[LOG_DICT_ENC_MAX];
+	size_t n = 0;
+
+#if MESH_LOG_STREAM_DICT
+	if (s_batch.p.count == 0 && s_key_due) {
+		s_key_due = false;
+		s_since_key = 0;
+		log_dict_enc_reset(&s_enc);
+		s_batch.p.flags |= MESH_LOG_BATCH_F_KEY;
+	}
+	n = log_dict_encode(&s_enc, line, len, rec);
+#else
+	rec[0] = (uint8_t)len;
+	memcpy(rec + 1, line, len);
+	n = len + 1;
+#endif
+
+	// не влазить — пачка йде як є; рядок відкриває наступну (історія неперервна, тож не keyframe)
+	if (s_batch.p.count == UINT8_MAX || s_batch_used + n > MESH_LOG_BATCH_DATA_MAX) batch_flush();
+
+#if MESH_LOG_STREAM_DICT
+	s_batch.p.flags |= MESH_LOG_BATCH_F_DICT;
+#endif
+	memcpy(&s_batch.p.data[s_batch_used], rec, n);
+	s_batch_used += n;
+	s_batch.p.count++;
+}
+
+static void mesh_log_stream_task(void *arg)
+{
+	uint32_t info_at = ms_now();
+	uint32_t flush_at = 0;
+	uint32_t last_drops = 0;
+	stream_item_t it;
+
+	for (;;) {
+		uint32_t now = ms_now();
+		bool in_mesh = !esp_mesh_is_root();	// без parent esp_mesh_send просто не пройде
+
+		if (s_batch.p.count > 0 && (int32_t)(now - flush_at) >= 0) {
+			if (s_enabled) batch_flush();
+			else batch_drop();
+		}
+
+		if (s_announce) {
+			s_announce = false;
+			info_at = now;
+		}
+
+		if ((int32_t)(now - info_at) >= 0) {
+			info_at = now + MESH_LOG_STREAM_INFO_MS;
+			if (in_mesh) send_nodeinfo();
+
+			// тільки в UART (рядки цієї таски не стрімляться)
+			uint32_t drops = atomic_load_explicit(&s_dropped_full, memory_order_relaxed) +
+					 atomic_load_explicit(&s_dropped_rate, memory_order_relaxed);
+			if (drops != last_drops) {
+				ESP_LOGW(TAG, "dropped %lu lines (queue full / rate limit)", (unsigned long)(drops - last_drops));
+				last_drops = drops;
+			}
+		}
+
+		uint32_t wake = info_at;
+		if (s_batch.p.count > 0 && (int32_t)(flush_at - wake) < 0) wake = flush_at;
+
+		if ((int32_t)(wake - now) > MESH_LOG_STREAM_ANNOUNCE_POLL_MS) wake = now + MESH_LOG_STREAM_ANNOUNCE_POLL_MS;
+
+		if (xQueueReceive(s_q, &it, pdMS_TO_TICKS(wake - now)) != pdTRUE) continue;
+
+		// стрім вимкнули, поки рядки чекали — root їх все одно не візьме
+		if (!s_enabled || !in_mesh) {
+			batch_drop();
+			continue;
+		}
+
+		batch_skip();
+		batch_add(it.line);
+		if (s_batch.p.count == 1) flush_at = ms_now() + MESH_LOG_STREAM_FLUSH_MS;
+	}
+}
+
+esp_err_t mesh_log_stream_init(const char *tag)
+{
+	if (s_q) return ESP_OK;
+
+	strncpy(s_tag, tag ? tag : "node", sizeof(s_tag) - 1);
+
+	// id з самого tag (FNV-1a, згорнутий у байт): інший tag — інший id, root побачить промах
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; s_tag[i]; i++) {
+		h ^= (uint8_t)s_tag[i];
+		h *= 16777619u;
+	}
+	s_tag_id = (uint8_t)(h ^ (h >> 8) ^ (h >> 16) ^ (h >> 24));
+	if (s_tag_id == 0) s_tag_id = 1;
+
+	s_q = xQueueCreate(MESH_LOG_STREAM_QUEUE, sizeof(stream_item_t));
+	if (!s_q) return ESP_ERR_NO_MEM;
+
+	if (xTaskCreate(mesh_log_stream_task, "mesh_log", 4096, NULL, MESH_LOG_STREAM_PRIO, &s_task) != pdPASS) {
+		vQueueDelete(s_q);
+		s_q = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+
+	s_orig_vprintf = esp_log_set_vprintf(&mesh_log_vprintf);
+	return ESP_OK;
+}
+
+esp_err_t mesh_log_stream_handle_ctrl(const void *pkt_buf, size_t pkt_len)
+{
+	if (!pkt_buf || pkt_len < MESH_LOG_CTRL_BASE_SIZE) return ESP_ERR_INVALID_SIZE;
+
+	const mesh_log_ctrl_packet_t *p = (const mesh_log_ctrl_packet_t *)pkt_buf;
+	bool enable = p->enable != 0;
+
+	if (p->flags & MESH_LOG_CTRL_F_ANNOUNCE) s_announce = true;
+
+	if (enable) {
+		uint16_t burst = (pkt_len >= sizeof(mesh_log_ctrl_packet_t) && p->rate_burst) ?
+				 p->rate_burst : MESH_LOG_RATE_BURST;
+
+		/*
+			Повний сплеск — тільки на новий ліміт або початок стріму. root шле enable і як
+			нагадування, і як прохання про keyframe: bucket root-а тоді не повний, і нода
+			з поповненим bucket-ом перевищила б його.
+		*/
+		portENTER_CRITICAL(&s_rate_lock);
+		if (!s_enabled || p->rate_lps != s_rate_lps || burst != s_rate_burst) {
+			s_tokens = (uint32_t)burst * 1000u;
+			s_refill_ms = ms_now();
+		}
+		s_rate_lps = p->rate_lps;
+		s_rate_burst = burst;
+		portEXIT_CRITICAL(&s_rate_lock);
+
+		// старий root (короткий пакет) фільтра не знає — все
+		bool has_flt = pkt_len >= offsetof(mesh_log_ctrl_packet_t, rate_burst);
+		uint8_t level = has_flt ? p->max_level : 0;
+		uint8_t mode = (has_flt && p->tags[0]) ? p->tag_mode : MESH_LOG_CTRL_TAGS_NONE;
+		bool flt_changed = false;
+
+		portENTER_CRITICAL(&s_flt_lock);
+		if (level != s_flt_level || mode != s_flt_mode ||
+		    (mode != MESH_LOG_CTRL_TAGS_NONE && strncmp(s_flt_tags, p->tags, sizeof(s_flt_tags)) != 0)) {
+			s_flt_level = level;
+			s_flt_mode = mode;
+			if (has_flt) memcpy(s_flt_tags, p->tags, sizeof(s_flt_tags));
+			s_flt_tags[has_flt ? sizeof(s_flt_tags) - 1 : 0] = '\0';
+			flt_changed = true;
+		}
+		portEXIT_CRITICAL(&s_flt_lock);
+
+		if (flt_changed) {
+			ESP_LOGI(TAG, "log stream filter: level %u, %s '%s'", (unsigned)level,
+				 mode == MESH_LOG_CTRL_TAGS_INCLUDE ? "only" :
+				 mode == MESH_LOG_CTRL_TAGS_EXCLUDE ? "except" : "any tag", s_flt_tags);
+		}
+#if MESH_LOG_STREAM_DICT
+		// enable — і прохання root почати історію заново (він її втратив)
+		s_key_due = true;
+#endif
+	} else if (s_q) {
+		xQueueReset(s_q);
+		atomic_store_explicit(&s_skipped, 0, memory_order_relaxed);	// нікому показувати
+	}
+
+	if (enable != s_enabled) {
+		s_enabled = enable;
+		ESP_LOGI(TAG, "log stream %s (rate %u/s)", enable ? "on" : "off", (unsigned)p->rate_lps);
+	}
+	return ESP_OK;
+}
+
+void mesh_log_stream_announce(void)
+{
+	s_announce = true;
+}
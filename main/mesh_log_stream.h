@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Нода: стрім свого лога на root (MESH_LOG_TYPE_BATCH), поки root просить (MESH_LOG_TYPE_CTRL).
+	- vprintf hook тільки кладе рядок у чергу (не чекає mesh); черга повна — рядок відкидається
+	- окрема таска з низьким пріоритетом шле рядки на root пачками (MESH_LOG_TYPE_BATCH, до MTU;
+	  пачка йде, коли повна або через MESH_LOG_STREAM_FLUSH_MS після першого рядка) і раз в MESH_LOG_STREAM_INFO_MS — NODEINFO,
+	  щоб нода була у списку дашборда (без цього root ніколи не попросить стрім); tag іде тільки
+	  в NODEINFO, пакети лога несуть 1-байтний tag_id
+	- з MESH_LOG_STREAM_DICT рядки стиснуті log_dict; CTRL enable від root = ще й прохання про keyframe
+	- фільтр з CTRL (рівень, include/exclude список tag) — теж у hook, до черги і до token bucket:
+	  непотрібне root-у не витрачає ні ефіру, ні ліміту, і не рахується втраченим
+	- rate_lps з CTRL тримається на ноді (token bucket тієї ж ємності, що й на root — rate_burst з CTRL,
+	  тож нода, що тримає ліміт, не впирається в ліміт root); зайве відкидається ще до черги,
+	  але займає номер (h.counter) — root бачить і ці рядки як втрачені
+	- стартує тільки в прошивці ноди (CONFIG_MESH_ROLE_ROOT=n); поки esp_mesh_is_root(),
+	  hook нічого не шле: лог root-а і так у local ring
+*/
+
+#ifndef MESH_LOG_STREAM_QUEUE
+	#define MESH_LOG_STREAM_QUEUE		16	// рядків у черзі (~200 байт кожен)
+#endif
+
+#ifndef MESH_LOG_STREAM_FLUSH_MS
+	#define MESH_LOG_STREAM_FLUSH_MS	100	// скільки рядок може чекати сусідів по пачці
+#endif
+
+#ifndef MESH_LOG_STREAM_DICT
+	#define MESH_LOG_STREAM_DICT		1	// рядки стиснуті log_dict (root розуміє обидва варіанти)
+#endif
+
+#ifndef MESH_LOG_STREAM_KEY_EVERY
+	#define MESH_LOG_STREAM_KEY_EVERY	16	// пачок між keyframe log_dict
+#endif
+
+#ifndef MESH_LOG_STREAM_INFO_MS
+	#define MESH_LOG_STREAM_INFO_MS		(60 * 1000)	// < NODE_DIR_AGE_MS на root
+#endif
+
+#ifndef MESH_LOG_STREAM_ANNOUNCE_POLL_MS
+	#define MESH_LOG_STREAM_ANNOUNCE_POLL_MS	1000	// як швидко таска помічає прохання про NODEINFO
+#endif
+
+#ifndef MESH_LOG_STREAM_PRIO
+	#define MESH_LOG_STREAM_PRIO		2
+#endif
+
+// Ставить vprintf hook і стартує таску. tag — як ноду підписати на root.
+esp_err_t	mesh_log_stream_init(const char *tag);
+
+// RX: викликаєш у mesh_rx_task, коли type == MESH_LOG_TYPE_CTRL
+esp_err_t	mesh_log_stream_handle_ctrl(const void *pkt_buf, size_t pkt_len);
+
+// Надіслати NODEINFO найближчим часом (напр. змінився root: новий не знає наш tag_id)
+void		mesh_log_stream_announce(void);
+
+#ifdef __cplusplus
+}
+#endif
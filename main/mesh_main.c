@@ -22,6 +22,8 @@
 #include "log_time_vprintf.h"
 #include "mesh_proto.h"
 #include "mesh_time_sync.h"
+#include "mesh_log_stream.h"
+#include "root_metrics.h"
 
 /* -------------------------------------------------------------------------- */
 /*  Константи / глобальні змінні                                              */
@@ -211,7 +213,7 @@ static void mesh_tx_task(void *arg)
 /* -------------------------------------------------------------------------- */
 static void mesh_rx_task(void *arg)
 {
-	uint8_t      rx_buf[256];
+	static uint8_t rx_buf[MESH_PKT_MAX];	// пачки лога — до MTU; static, щоб не з'їдати стек таски
 	mesh_data_t  data;
 	mesh_addr_t  from;
 	int          flag = 0;
@@ -227,11 +229,13 @@ static void mesh_rx_task(void *arg)
 		err = esp_mesh_recv(&from, &data, portMAX_DELAY, &flag, NULL, 0);
 		if (err != ESP_OK) {
 			ESP_LOGE(MESH_TAG, "esp_mesh_recv failed: 0x%x (%s)", err, esp_err_to_name(err));
+			root_metrics_rx_error();
 			continue;
 		}
 
 		if (data.size < sizeof(mesh_pkt_hdr_t)) {
 			ESP_LOGW(MESH_TAG, "RX too short: %d bytes", data.size);
+			root_metrics_rx_short();
 			continue;
 		}
 
@@ -239,26 +243,48 @@ static void mesh_rx_task(void *arg)
 
 		// наш протокол?
 		if (h->magic == MESH_PKT_MAGIC && h->version == MESH_PKT_VERSION) {
+			root_metrics_rx(h->type, data.size);
 
+#if CONFIG_MESH_ROLE_ROOT
 			// 1) NodeInfo (tag) — для меню
 			if (h->type == MESH_LOG_TYPE_NODEINFO) {
-				if (data.size >= sizeof(mesh_nodeinfo_packet_t)) {
+				// стара прошивка шле NODEINFO без tag_id — приймаємо з id 0
+				if (data.size >= offsetof(mesh_nodeinfo_packet_t, tag_id)) {
 					const mesh_nodeinfo_packet_t *p = (const mesh_nodeinfo_packet_t *)rx_buf;
-					log_http_server_node_seen(p->h.src_mac, p->tag);
+					uint8_t tag_id = (data.size >= sizeof(mesh_nodeinfo_packet_t)) ? p->tag_id : 0;
+					log_http_server_node_seen(p->h.src_mac, p->tag, tag_id);
 				}
 				continue;
 			}
 
-			// 2) Log line — пишемо в буфер тільки якщо ця нода вибрана
+			// 2) Log line — пишемо в ring ноди
 			if (h->type == MESH_LOG_TYPE_LINE) {
 				if (data.size >= sizeof(mesh_log_line_packet_t)) {
 					const mesh_log_line_packet_t *p = (const mesh_log_line_packet_t *)rx_buf;
-					log_http_server_node_seen(p->h.src_mac, p->tag);          // щоб нода була у списку
-					log_http_server_remote_line(p->h.src_mac, p->tag, p->line); // буферизація (всередині є фільтр по selected)
+					log_http_server_node_seen(p->h.src_mac, p->tag, 0);       // щоб нода була у списку
+					log_http_server_remote_line(p->h.src_mac, p->tag, p->line); // у ring цієї ноди (якщо він є)
 				}
 				continue;
 			}
 
+			// 2b) Пачка рядків лога — той самий ring, один раз на пакет
+			if (h->type == MESH_LOG_TYPE_BATCH) {
+				if (data.size >= sizeof(mesh_log_batch_packet_t)) {
+					const mesh_log_batch_packet_t *p = (const mesh_log_batch_packet_t *)rx_buf;
+					log_http_server_node_seen_id(p->h.src_mac, p->tag_id);
+					log_http_server_remote_batch(p->h.src_mac, p->h.counter, p->flags, p->data,
+						data.size - sizeof(mesh_log_batch_packet_t), p->count);
+				}
+				continue;
+			}
+#endif
+
+			// 3) CTRL від root — вмикає/вимикає стрім нашого лога
+			if (h->type == MESH_LOG_TYPE_CTRL) {
+				mesh_log_stream_handle_ctrl(rx_buf, data.size);
+				continue;
+			}
+
 			// 4) Старий TEXT (type=1) — твоя поточна логіка
 			if (h->type == MESH_PKT_TYPE_TEXT) {
 				if (data.size >= sizeof(mesh_packet_t)) {
@@ -283,6 +309,7 @@ static void mesh_rx_task(void *arg)
 
 		// не наш протокол — можеш або ігнор, або стару обробку
 		ESP_LOGW(MESH_TAG, "RX unknown packet from " MACSTR " len=%u", MAC2STR(from.addr), (unsigned)data.size);
+		root_metrics_rx_unknown();
 	}
 	vTaskDelete(NULL);
 }
@@ -439,6 +466,9 @@ static void mesh_event_handler(void *arg,
 		ESP_LOGI(MESH_TAG,
 		         "<MESH_EVENT_ROOT_ADDRESS> root:" MACSTR,
 		         MAC2STR(ra->addr));
+
+		// новий root не знає нашого tag_id — анонсуємось, не чекаючи періоду
+		mesh_log_stream_announce();
 	}
 	break;
 
@@ -486,10 +516,12 @@ static void ip_event_handler(void *arg,
 
 	mesh_time_sync_root_start(5000);
 
+#if CONFIG_MESH_ROLE_ROOT
 	// Якщо ми root – запускаємо HTTP-сервер
 	if (esp_mesh_is_root()) {
 		log_http_server_start();
 	}
+#endif
 }
 
 
@@ -526,9 +558,12 @@ void app_main(void)
 	                               &mesh_event_handler, NULL));
     // --- налаштування типу вузла / фіксований root ---
 
+    // root фіксований: це налаштування однакове на всіх пристроях мережі (без виборів root)
+    ESP_ERROR_CHECK(esp_mesh_fix_root(true));
+#if CONFIG_MESH_ROLE_ROOT
         // Ця прошивка буде завжди root (якщо може підключитися до роутера)
-    ESP_ERROR_CHECK(esp_mesh_fix_root(true));       // не віддаємо роль root
     ESP_ERROR_CHECK(esp_mesh_set_type(MESH_ROOT));  // я – root
+#endif
 
 
 	ESP_ERROR_CHECK(esp_mesh_set_topology(CONFIG_MESH_TOPOLOGY));
@@ -576,7 +611,11 @@ void app_main(void)
 
 	uart_bridge_init();
 	uart_bridge_start();
-	log_http_server_init();
+#if CONFIG_MESH_ROLE_ROOT
+	log_http_server_init();		// local ring, hook і log_flash — тільки на root
+#else
+	mesh_log_stream_init(MESH_TAG);	// root свій лог і так має в local ring
+#endif
 	mesh_time_sync_init();
 	
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -19,6 +20,10 @@ extern "C" {
 #define MESH_LOG_TYPE_LINE		3
 #define MESH_LOG_TYPE_NODEINFO		4
 #define MESH_LOG_TYPE_CTRL		5
+#define MESH_LOG_TYPE_BATCH		6
+
+// Пакет не більший за MESH_MPS (esp_mesh.h) — під нього і буфер RX
+#define MESH_PKT_MAX			1472
 
 typedef struct __attribute__((packed)) {
 	uint8_t		magic;
@@ -40,10 +45,14 @@ typedef struct __attribute__((packed)) {
 	char		payload[32];
 } mesh_packet_t;
 
-// Анонс "яка це нода" => tag
+/*
+	Анонс "яка це нода" => tag. Пакети лога далі несуть тільки tag_id; root, що не знає
+	tag для цього id (новий root, перезапуск), просить анонс знову (MESH_LOG_CTRL_F_ANNOUNCE).
+*/
 typedef struct __attribute__((packed)) {
 	mesh_pkt_hdr_t	h;
 	char		tag[16];		// MESH_TAG (обрізаємо якщо довше)
+	uint8_t		tag_id;			// != 0, змінюється разом з tag
 } mesh_nodeinfo_packet_t;
 
 // Одна строка лога
@@ -53,13 +62,52 @@ typedef struct __attribute__((packed)) {
 	char		line[192];		// сама строка (з '\n' або без — root нормалізує)
 } mesh_log_line_packet_t;
 
-// Керування стрімом лога (root -> node)
+/*
+	Кілька рядків лога одним пакетом (змінної довжини, до MESH_PKT_MAX):
+	data = count записів { uint8_t len; char line[len]; } без '\0' і без '\n',
+	з MESH_LOG_BATCH_F_DICT — count рядків у форматі log_dict.h.
+	h.counter — номер першого рядка, далі рядки йдуть підряд.
+*/
+#define MESH_LOG_BATCH_F_DICT		0x01	// рядки стиснуті log_dict
+#define MESH_LOG_BATCH_F_KEY		0x02	// історія log_dict з нуля (keyframe)
+
+typedef struct __attribute__((packed)) {
+	mesh_pkt_hdr_t	h;
+	uint8_t		tag_id;			// як у mesh_nodeinfo_packet_t
+	uint8_t		count;
+	uint8_t		flags;			// MESH_LOG_BATCH_F_*
+	uint8_t		data[];
+} mesh_log_batch_packet_t;
+
+#define MESH_LOG_BATCH_DATA_MAX		(MESH_PKT_MAX - sizeof(mesh_log_batch_packet_t))
+
+#define MESH_LOG_CTRL_F_ANNOUNCE	0x01	// надіслати NODEINFO (root не знає tag_id)
+
+#define MESH_LOG_CTRL_TAGS_NONE		0	// tags не діє
+#define MESH_LOG_CTRL_TAGS_INCLUDE	1	// тільки рядки з tag зі списку
+#define MESH_LOG_CTRL_TAGS_EXCLUDE	2	// всі, крім tag зі списку
+
+/*
+	Керування стрімом лога (root -> node). Фільтр (max_level, tags) нода застосовує ще до черги:
+	відфільтроване не йде в mesh і не рахується втраченим. Старі root шлють пакет до max_level
+	(MESH_LOG_CTRL_BASE_SIZE) — тоді без фільтра; старі ноди хвіст просто не читають.
+*/
 typedef struct __attribute__((packed)) {
 	mesh_pkt_hdr_t	h;
 	uint8_t		enable;			// 0/1
-	uint8_t		rsv[3];
+	uint8_t		flags;			// MESH_LOG_CTRL_F_*
+	uint16_t	rate_lps;		// не більше стількох рядків/с (0 — без ліміту; так і шлють старі root)
+	uint8_t		max_level;		// 0 — всі; інакше рівні 1 (E) .. max_level, як LOG_RING_LVL_*
+	uint8_t		tag_mode;		// MESH_LOG_CTRL_TAGS_*
+	char		tags[48];		// "tag1,tag2", '\0' в кінці
+	uint16_t	rate_burst;		// ємність token bucket ноди, рядків (= ліміт root; 0 — MESH_LOG_RATE_BURST)
 } mesh_log_ctrl_packet_t;
 
+// Сплеск понад rate_lps, якщо root його не передав (старий root). Типовий і для node_dir на root.
+#define MESH_LOG_RATE_BURST		60
+
+#define MESH_LOG_CTRL_BASE_SIZE		offsetof(mesh_log_ctrl_packet_t, max_level)
+
 #ifdef __cplusplus
 }
 #endif
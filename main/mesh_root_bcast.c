@@ -5,6 +5,7 @@
 #include "sdkconfig.h"     // щоб мати CONFIG_MESH_ROUTE_TABLE_SIZE
 
 #include "mesh_root_bcast.h"
+#include "root_metrics.h"
 
 // ВАЖЛИВО: структура й константи повинні збігатись з тим,
 // що вже є в mesh_main.c
@@ -84,6 +85,7 @@ void mesh_root_broadcast_text(const char *payload)
 
 	for (int i = 0; i < route_table_size; ++i) {
 		err = esp_mesh_send(&route_table[i], &data, MESH_DATA_P2P, NULL, 0);
+		root_metrics_bcast(err == ESP_OK);
 		if (err != ESP_OK) {
 			ESP_LOGE(TAG,
 			         "send[%d] failed: 0x%x (%s)",
@@ -13,6 +13,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "root_metrics.h"
+
 static const char *TAG = "mesh_time";
 
 // Має співпасти з твоїм mesh_packet_t
@@ -111,6 +113,7 @@ static esp_err_t root_send_time_to_all(int64_t epoch_sec, uint32_t seq)
 	esp_err_t last_err = ESP_OK;
 	for (int i = 0; i < route_table_size; i++) {
 		esp_err_t e = esp_mesh_send(&route_table[i], &data, MESH_DATA_P2P, NULL, 0);
+		root_metrics_bcast(e == ESP_OK);
 		if (e != ESP_OK) last_err = e;
 	}
 	return last_err;
@@ -0,0 +1,412 @@
+#include "node_dir.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+	Записи лежать у s_ent[], хеш-індекс s_idx[] тримає номер запису + 1 (0 = порожньо).
+	Індекс заповнений не більше ніж наполовину; видалення — зсувом назад (без tombstone),
+	щоб пошук ніколи не деградував до повного проходу.
+*/
+
+#define NODE_DIR_HASH	((NODE_DIR_MAX) <= 32 ? 64 : (NODE_DIR_MAX) <= 64 ? 128 : \
+			 (NODE_DIR_MAX) <= 128 ? 256 : (NODE_DIR_MAX) <= 256 ? 512 : 1024)
+
+_Static_assert(NODE_DIR_MAX > 0 && NODE_DIR_MAX <= 512, "NODE_DIR_MAX out of range");
+
+typedef struct {
+	node_dir_ent_t	e;
+	bool		used;
+	uint32_t	tokens;		// token bucket, тисячні рядка
+	uint32_t	refill_ms;
+	uint32_t	remind_ms;	// коли востаннє просили ноду про ліміт
+	uint32_t	next_seq;	// очікуваний номер рядка (0 — ще не знаємо)
+	uint32_t	lost_pending;	// втрачено, ще не показано в ring
+	uint32_t	announce_ms;	// коли востаннє просили NODEINFO
+} dir_slot_t;
+
+static dir_slot_t s_ent[NODE_DIR_MAX];
+static uint16_t s_idx[NODE_DIR_HASH];
+static uint32_t s_count = 0;
+static uint32_t s_evicted = 0;
+static uint32_t s_suppressed = 0;
+static uint32_t s_lost = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t ms_now(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static uint32_t mac_hash(const uint8_t mac[6])
+{
+	// FNV-1a; OUI у перших байтах однаковий майже для всіх нод, тож мішаємо всі 6
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < 6; i++) {
+		h ^= mac[i];
+		h *= 16777619u;
+	}
+	return h & (NODE_DIR_HASH - 1);
+}
+
+// під lock: позиція в s_idx (або -1)
+static int idx_find(const uint8_t mac[6])
+{
+	uint32_t h = mac_hash(mac);
+
+	while (s_idx[h]) {
+		if (memcmp(s_ent[s_idx[h] - 1].e.mac, mac, 6) == 0) return (int)h;
+		h = (h + 1) & (NODE_DIR_HASH - 1);
+	}
+	return -1;
+}
+
+static void idx_insert(uint32_t ent)
+{
+	uint32_t h = mac_hash(s_ent[ent].e.mac);
+
+	while (s_idx[h]) h = (h + 1) & (NODE_DIR_HASH - 1);
+	s_idx[h] = (uint16_t)(ent + 1);
+}
+
+// під lock: видалити запис за позицією в індексі (зсув назад наступних у ланцюжку)
+static void idx_remove(uint32_t i)
+{
+	uint32_t ent = s_idx[i] - 1;
+	uint32_t j = i;
+
+	for (;;) {
+		j = (j + 1) & (NODE_DIR_HASH - 1);
+		if (!s_idx[j]) break;
+
+		uint32_t k = mac_hash(s_ent[s_idx[j] - 1].e.mac);
+
+		// запис на j може зайняти дірку i, якщо його "дім" k не лежить циклічно в (i, j]
+		bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+		if (stays) continue;
+
+		s_idx[i] = s_idx[j];
+		i = j;
+	}
+	s_idx[i] = 0;
+
+	s_ent[ent].used = false;
+	s_count--;
+}
+
+// під lock: найдовше мовчазна нода
+static void evict_oldest(void)
+{
+	uint32_t now = ms_now();
+	int oldest = -1;
+
+	for (uint32_t i = 0; i < NODE_DIR_MAX; i++) {
+		if (!s_ent[i].used) continue;
+		if (oldest < 0 || (now - s_ent[i].e.last_seen_ms) > (now - s_ent[oldest].e.last_seen_ms)) oldest = (int)i;
+	}
+	if (oldest < 0) return;
+
+	int h = idx_find(s_ent[oldest].e.mac);
+	if (h >= 0) {
+		idx_remove((uint32_t)h);
+		s_evicted++;
+	}
+}
+
+// під lock
+static dir_slot_t *slot_find(const uint8_t mac[6])
+{
+	int h = idx_find(mac);
+	return (h >= 0) ? &s_ent[s_idx[h] - 1] : NULL;
+}
+
+static void set_tag(node_dir_ent_t *e, const char *tag)
+{
+	strncpy(e->tag, tag, sizeof(e->tag) - 1);
+	e->tag[sizeof(e->tag) - 1] = '\0';
+}
+
+// під lock: новий запис (при повному довіднику — замість найстарішого)
+static dir_slot_t *slot_add(const uint8_t mac[6], const char *tag, uint32_t now)
+{
+	if (s_count >= NODE_DIR_MAX) evict_oldest();
+
+	for (uint32_t i = 0; i < NODE_DIR_MAX; i++) {
+		if (s_ent[i].used) continue;
+
+		dir_slot_t *s = &s_ent[i];
+		memset(s, 0, sizeof(*s));
+		memcpy(s->e.mac, mac, 6);
+		set_tag(&s->e, (tag && tag[0]) ? tag : "node");
+		s->e.first_seen_ms = now;
+		s->e.last_seen_ms = now;
+
+		s->used = true;
+		s->tokens = NODE_DIR_RATE_BURST * 1000u;
+		s->refill_ms = now;
+		s->remind_ms = now - NODE_DIR_RATE_REMIND_MS;
+		s->announce_ms = now - NODE_DIR_ANNOUNCE_MS;
+		s_count++;
+		idx_insert(i);
+		return s;
+	}
+	return NULL;
+}
+
+bool node_dir_seen(const uint8_t mac[6], const char *tag, uint8_t tag_id)
+{
+	if (!mac) return false;
+
+	bool changed = false;
+	uint32_t now = ms_now();
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		int h = idx_find(mac);
+
+		if (h >= 0) {
+			node_dir_ent_t *e = &s_ent[s_idx[h] - 1].e;
+			if (tag && tag[0] && strncmp(e->tag, tag, sizeof(e->tag) - 1) != 0) {
+				set_tag(e, tag);
+				changed = true;
+			}
+			if (tag_id) e->tag_id = tag_id;
+			e->last_seen_ms = now;
+		} else {
+			dir_slot_t *s = slot_add(mac, tag, now);
+			if (s) {
+				s->e.tag_id = tag_id;
+				changed = true;
+			}
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return changed;
+}
+
+bool node_dir_seen_id(const uint8_t mac[6], uint8_t tag_id, bool *announce)
+{
+	if (announce) *announce = false;
+	if (!mac) return false;
+
+	bool changed = false;
+	uint32_t now = ms_now();
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		dir_slot_t *s = slot_find(mac);
+		if (!s) {
+			// NODEINFO цієї ноди ще не було (або root перезапустився) — поки під іменем "node"
+			s = slot_add(mac, NULL, now);
+			changed = (s != NULL);
+		}
+		if (s) {
+			s->e.last_seen_ms = now;
+
+			// промах: tag цього id невідомий — попросити NODEINFO, але не на кожен пакет
+			if (s->e.tag_id != tag_id && (now - s->announce_ms) >= NODE_DIR_ANNOUNCE_MS) {
+				s->announce_ms = now;
+				if (announce) *announce = true;
+			}
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return changed;
+}
+
+bool node_dir_admit_line(const uint8_t mac[6], uint32_t bytes, bool *remind)
+{
+	bool ok = true;
+	uint32_t now = ms_now();
+
+	if (remind) *remind = false;
+	if (!mac) return true;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		int h = idx_find(mac);
+		if (h >= 0) {
+			dir_slot_t *s = &s_ent[s_idx[h] - 1];
+
+			// поповнення: NODE_DIR_RATE_LPS рядків за 1000 мс = LPS тисячних за мс
+			uint32_t dt = now - s->refill_ms;
+			const uint32_t cap = NODE_DIR_RATE_BURST * 1000u;
+			if (dt >= cap / NODE_DIR_RATE_LPS) {
+				s->tokens = cap;
+			} else {
+				s->tokens += dt * NODE_DIR_RATE_LPS;
+				if (s->tokens > cap) s->tokens = cap;
+			}
+			s->refill_ms = now;
+
+			if (s->tokens >= 1000u) {
+				s->tokens -= 1000u;
+				s->e.lines++;
+				s->e.bytes += bytes;
+			} else {
+				ok = false;
+				s->e.suppressed++;
+				s_suppressed++;
+
+				if ((now - s->remind_ms) >= NODE_DIR_RATE_REMIND_MS) {
+					s->remind_ms = now;
+					if (remind) *remind = true;
+				}
+			}
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return ok;
+}
+// під lock
+static void add_lost(dir_slot_t *s, uint32_t n)
+{
+	s->e.lost += n;
+	s->lost_pending += n;
+	s_lost += n;
+}
+
+void node_dir_track_seq(const uint8_t mac[6], uint32_t seq, uint32_t count)
+{
+	if (!mac) return;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		dir_slot_t *s = slot_find(mac);
+		if (s) {
+			int32_t gap = (int32_t)(seq - s->next_seq);
+			if (s->next_seq != 0 && gap > 0) add_lost(s, (uint32_t)gap);
+			s->next_seq = seq + count;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+}
+
+void node_dir_lost(const uint8_t mac[6], uint32_t count)
+{
+	if (!mac || count == 0) return;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		dir_slot_t *s = slot_find(mac);
+		if (s) add_lost(s, count);
+	}
+	portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t node_dir_take_lost(const uint8_t mac[6])
+{
+	uint32_t n = 0;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		dir_slot_t *s = slot_find(mac);
+		if (s) {
+			n = s->lost_pending;
+			s->lost_pending = 0;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return n;
+}
+
+bool node_dir_get(const uint8_t mac[6], node_dir_ent_t *out)
+{
+	bool ok = false;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		int h = idx_find(mac);
+		if (h >= 0) {
+			*out = s_ent[s_idx[h] - 1].e;
+			ok = true;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return ok;
+}
+
+bool node_dir_set_filter(const uint8_t mac[6], uint8_t level, uint8_t mode, const char *tags)
+{
+	bool ok = false;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		int h = idx_find(mac);
+		if (h >= 0) {
+			node_dir_ent_t *e = &s_ent[s_idx[h] - 1].e;
+			e->flt_level = level;
+			e->flt_mode = mode;
+			strncpy(e->flt_tags, tags ? tags : "", sizeof(e->flt_tags) - 1);
+			e->flt_tags[sizeof(e->flt_tags) - 1] = '\0';
+			ok = true;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return ok;
+}
+
+bool node_dir_at(uint32_t i, node_dir_ent_t *out)
+{
+	if (i >= NODE_DIR_MAX) return false;
+
+	bool ok = false;
+
+	portENTER_CRITICAL(&s_lock);
+	if (s_ent[i].used) {
+		*out = s_ent[i].e;
+		ok = true;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return ok;
+}
+
+uint32_t node_dir_expire(uint32_t max_age_ms)
+{
+	uint32_t now = ms_now();
+	uint32_t removed = 0;
+
+	for (uint32_t i = 0; i < NODE_DIR_MAX; i++) {
+		// lock по одному запису — не тримаємо spinlock на весь прохід
+		portENTER_CRITICAL(&s_lock);
+		if (s_ent[i].used && (now - s_ent[i].e.last_seen_ms) > max_age_ms) {
+			int h = idx_find(s_ent[i].e.mac);
+			if (h >= 0) {
+				idx_remove((uint32_t)h);
+				removed++;
+			}
+		}
+		portEXIT_CRITICAL(&s_lock);
+	}
+
+	return removed;
+}
+
+uint32_t node_dir_count(void)
+{
+	return s_count;
+}
+
+uint32_t node_dir_evicted(void)
+{
+	return s_evicted;
+}
+
+uint32_t node_dir_suppressed(void)
+{
+	return s_suppressed;
+}
+
+uint32_t node_dir_lost_total(void)
+{
+	return s_lost;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"     // щоб мати CONFIG_MESH_ROUTE_TABLE_SIZE
+
+#include "mesh_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Довідник remote нод, яких бачив root (для /nodes, /select, статистики).
+	- хеш по MAC (open addressing), пошук O(1) — викликається на кожен RX пакет
+	- розмір під CONFIG_MESH_ROUTE_TABLE_SIZE; коли повний — витісняється найстаріший last_seen
+	- ноди, що мовчать довше за NODE_DIR_AGE_MS, прибираються (node_dir_expire)
+	- рядки лога кожної ноди проходять token bucket (NODE_DIR_RATE_LPS, сплеск NODE_DIR_RATE_BURST):
+	  зайві відкидаються і рахуються, щоб одна балакуча нода не забила RX і ring-и
+	- нумерація рядків ноди (h.counter пачки) перевіряється: дірка = втрачені рядки (lost),
+	  непоказані ще втрати віддає node_dir_take_lost() — для мітки в ring перед наступними рядками
+	- фільтр стріму ноди (рівень, tag) живе тут же і йде в кожен CTRL enable; нода, що випала
+	  з довідника, після повернення стрімить без фільтра
+*/
+
+#ifndef NODE_DIR_MAX
+	#define NODE_DIR_MAX			CONFIG_MESH_ROUTE_TABLE_SIZE
+#endif
+
+#ifndef NODE_DIR_AGE_MS
+	#define NODE_DIR_AGE_MS			(10 * 60 * 1000)
+#endif
+
+#ifndef NODE_DIR_RATE_LPS
+	#define NODE_DIR_RATE_LPS		20	// рядків/с з однієї ноди; той самий ліміт іде ноді в CTRL
+#endif
+
+#ifndef NODE_DIR_RATE_BURST
+	#define NODE_DIR_RATE_BURST		MESH_LOG_RATE_BURST	// стільки рядків підряд без обмеження (напр. boot ноди); йде ноді в CTRL
+#endif
+
+#ifndef NODE_DIR_ANNOUNCE_MS
+	#define NODE_DIR_ANNOUNCE_MS		5000	// не частіше просимо NODEINFO у ноди з невідомим tag_id
+#endif
+
+#define NODE_DIR_FLT_TAGS		48	// = mesh_log_ctrl_packet_t.tags
+
+#ifndef NODE_DIR_RATE_REMIND_MS
+	#define NODE_DIR_RATE_REMIND_MS		5000	// не частіше нагадуємо ноді ліміт, поки вона його перевищує
+#endif
+
+typedef struct {
+	uint8_t		mac[6];
+	char		tag[16];
+	uint32_t	first_seen_ms;
+	uint32_t	last_seen_ms;
+	uint32_t	lines;		// прийнятих рядків лога
+	uint32_t	bytes;		// байт тексту в них
+	uint32_t	suppressed;	// відкинуто token bucket-ом
+	uint32_t	lost;		// не дійшло: дірки в нумерації рядків ноди і пачки, що не декодувались
+	uint8_t		tag_id;		// id, під яким нода анонсувала tag (0 — не анонсувала)
+	uint8_t		flt_level;	// фільтр стріму: 0 — всі рівні, інакше 1 (E) .. flt_level
+	uint8_t		flt_mode;	// MESH_LOG_CTRL_TAGS_*
+	char		flt_tags[NODE_DIR_FLT_TAGS];	// "tag1,tag2"
+} node_dir_ent_t;
+
+// Оновити/додати ноду (NODEINFO; tag_id 0 — старий пакет без id). true — змінилось те, що видно в /nodes.
+bool		node_dir_seen(const uint8_t mac[6], const char *tag, uint8_t tag_id);
+
+/*
+	Пакет лога з tag_id замість tag (без копіювання рядка). true — нова нода.
+	*announce = true — id не той, що в NODEINFO (чи NODEINFO не було): час попросити ноду анонсуватись
+	(не частіше за NODE_DIR_ANNOUNCE_MS).
+*/
+bool		node_dir_seen_id(const uint8_t mac[6], uint8_t tag_id, bool *announce);
+
+/*
+	Рядок лога від ноди: true — прийняти (і порахувати), false — понад ліміт, відкинути.
+	*remind = true — нода перевищує ліміт і давно не чула про нього (час повторити CTRL).
+	Ноди ще нема в довіднику — приймаємо.
+*/
+bool		node_dir_admit_line(const uint8_t mac[6], uint32_t bytes, bool *remind);
+
+/*
+	Пачка рядків seq .. seq + count - 1. Пропущені номери перед seq — втрачені.
+	Номер менший за очікуваний — нода перезапустилась (нумерація з початку), не втрата.
+*/
+void		node_dir_track_seq(const uint8_t mac[6], uint32_t seq, uint32_t count);
+
+// Рядки, що дійшли, але їх не вдалось прочитати (напр. пачка log_dict без історії)
+void		node_dir_lost(const uint8_t mac[6], uint32_t count);
+
+// Втрати, ще не показані в ring (і скинути)
+uint32_t	node_dir_take_lost(const uint8_t mac[6]);
+
+bool		node_dir_get(const uint8_t mac[6], node_dir_ent_t *out);
+
+// Фільтр, з яким нода шле лог (тільки запам'ятати — CTRL шле caller). false — ноди нема.
+bool		node_dir_set_filter(const uint8_t mac[6], uint8_t level, uint8_t mode, const char *tags);
+
+// Обхід по слотах: i у [0, NODE_DIR_MAX); false — слот порожній
+bool		node_dir_at(uint32_t i, node_dir_ent_t *out);
+
+// Прибрати ноди без пакетів довше за max_age_ms. Повертає скільки прибрано.
+uint32_t	node_dir_expire(uint32_t max_age_ms);
+
+uint32_t	node_dir_count(void);
+uint32_t	node_dir_evicted(void);
+uint32_t	node_dir_suppressed(void);	// всього відкинутих рядків з boot
+uint32_t	node_dir_lost_total(void);	// всього втрачених рядків з boot
+
+#ifdef __cplusplus
+}
+#endif
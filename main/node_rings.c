@@ -0,0 +1,324 @@
+#include "node_rings.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+_Static_assert((NODE_RINGS_NODE_BYTES & (NODE_RINGS_NODE_BYTES - 1)) == 0, "NODE_RINGS_NODE_BYTES must be a power of two");
+
+typedef struct {
+	log_ring_t	*ring;		// local — статичний, remote — з heap разом з ареною
+	uint8_t		mac[6];
+	uint32_t	gen;
+	uint32_t	last_used_ms;
+	uint16_t	refs;
+	uint16_t	viewers;
+	bool		live;		// видимий для lookup
+	bool		dying;		// витіснений, чекає refs == 0
+	bool		pinned;
+} ring_slot_t;
+
+// витіснені під lock; звільняємо і повідомляємо вже після
+typedef struct {
+	uint8_t		mac[6];
+	log_ring_t	*ring;		// NULL — ще читають, звільнить останній release
+} evicted_t;
+
+static ring_slot_t s_slots[NODE_RINGS_MAX];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_budget = NODE_RINGS_BUDGET;
+static uint32_t s_allocated = 0;
+static uint32_t s_gen = 0;
+static node_rings_evict_cb_t s_on_evict = NULL;
+
+static log_ring_t *ring_alloc(void)
+{
+	log_ring_t *r = malloc(sizeof(*r));
+	void *buf = heap_caps_aligned_alloc(LOG_RING_ALIGN, NODE_RINGS_NODE_BYTES, MALLOC_CAP_8BIT);
+
+	if (!r || !buf) {
+		free(r);
+		heap_caps_free(buf);
+		return NULL;
+	}
+	log_ring_init(r, buf, NODE_RINGS_NODE_BYTES);
+	return r;
+}
+
+static void ring_free(log_ring_t *r)
+{
+	if (!r) return;
+	heap_caps_free(r->buf);
+	free(r);
+}
+
+static uint32_t ms_now(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static ring_slot_t *find_live(const uint8_t mac[6])
+{
+	for (int i = 0; i < NODE_RINGS_MAX; i++) {
+		if (s_slots[i].live && memcmp(s_slots[i].mac, mac, 6) == 0) return &s_slots[i];
+	}
+	return NULL;
+}
+
+// Кандидат на витіснення: спершу без глядачів, серед них — найдовше без перегляду
+static ring_slot_t *pick_victim(void)
+{
+	ring_slot_t *best = NULL;
+	uint32_t now = ms_now();
+
+	for (int i = 0; i < NODE_RINGS_MAX; i++) {
+		ring_slot_t *s = &s_slots[i];
+		if (!s->live || s->pinned) continue;
+
+		if (!best) {
+			best = s;
+			continue;
+		}
+		if ((s->viewers > 0) != (best->viewers > 0)) {
+			if (s->viewers == 0) best = s;
+			continue;
+		}
+		if ((now - s->last_used_ms) > (now - best->last_used_ms)) best = s;
+	}
+	return best;
+}
+
+// під lock
+static void evict_slot(ring_slot_t *s, evicted_t *out)
+{
+	memcpy(out->mac, s->mac, 6);
+	out->ring = NULL;
+
+	s->live = false;
+	s_allocated -= s->ring->size;
+
+	if (s->refs == 0) {
+		out->ring = s->ring;
+		memset(s, 0, sizeof(*s));
+	} else {
+		s->dying = true;
+	}
+}
+
+static void finish_evictions(const evicted_t *ev, int n)
+{
+	for (int i = 0; i < n; i++) {
+		ring_free(ev[i].ring);
+		if (s_on_evict) s_on_evict(ev[i].mac);
+	}
+}
+
+void node_rings_init(const uint8_t local_mac[6], log_ring_t *local, node_rings_evict_cb_t on_evict)
+{
+	portENTER_CRITICAL(&s_lock);
+	{
+		ring_slot_t *s = &s_slots[0];
+
+		// local ring статичний і вже міг отримати рядки — не ініціалізуємо
+		s->ring = local;
+		memcpy(s->mac, local_mac, 6);
+		s->gen = ++s_gen;
+		s->last_used_ms = ms_now();
+		s->live = true;
+		s->pinned = true;
+		s_allocated = local->size;
+		s_on_evict = on_evict;
+	}
+	portEXIT_CRITICAL(&s_lock);
+}
+
+log_ring_t *node_rings_acquire(const uint8_t mac[6], uint32_t *gen)
+{
+	log_ring_t *r = NULL;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		ring_slot_t *s = find_live(mac);
+		if (s) {
+			s->refs++;
+			if (gen) *gen = s->gen;
+			r = s->ring;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return r;
+}
+
+log_ring_t *node_rings_open(const uint8_t mac[6], uint32_t *gen, bool *created)
+{
+	if (created) *created = false;
+
+	log_ring_t *r = node_rings_acquire(mac, gen);
+	if (r) return r;
+
+	// арену готуємо поза lock (malloc + memset під spinlock не можна)
+	log_ring_t *fresh = ring_alloc();
+	if (!fresh) return NULL;
+
+	evicted_t ev[NODE_RINGS_MAX];
+	int n_ev = 0;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		// поки готували — хтось міг уже створити
+		ring_slot_t *s = find_live(mac);
+		if (s) {
+			s->refs++;
+			if (gen) *gen = s->gen;
+			r = s->ring;
+		} else {
+			// звільняємо місце під бюджет і слот
+			for (;;) {
+				bool have_slot = false;
+				for (int i = 0; i < NODE_RINGS_MAX; i++) {
+					if (!s_slots[i].live && !s_slots[i].dying) {
+						have_slot = true;
+						break;
+					}
+				}
+				if (have_slot && s_allocated + NODE_RINGS_NODE_BYTES <= s_budget) break;
+
+				ring_slot_t *v = pick_victim();
+				if (!v) break;
+				evict_slot(v, &ev[n_ev++]);
+			}
+
+			for (int i = 0; i < NODE_RINGS_MAX; i++) {
+				ring_slot_t *f = &s_slots[i];
+				if (f->live || f->dying) continue;
+				if (s_allocated + NODE_RINGS_NODE_BYTES > s_budget) break;
+
+				f->ring = fresh;
+				memcpy(f->mac, mac, 6);
+				f->gen = ++s_gen;
+				f->last_used_ms = ms_now();
+				f->refs = 1;
+				f->viewers = 0;
+				f->live = true;
+				s_allocated += NODE_RINGS_NODE_BYTES;
+
+				if (gen) *gen = f->gen;
+				r = f->ring;
+				fresh = NULL;
+				if (created) *created = true;
+				break;
+			}
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	ring_free(fresh);	// не знадобилась (або не влізли в бюджет)
+	finish_evictions(ev, n_ev);
+	return r;
+}
+
+void node_rings_release(log_ring_t *r)
+{
+	if (!r) return;
+
+	log_ring_t *to_free = NULL;
+
+	portENTER_CRITICAL(&s_lock);
+	for (int i = 0; i < NODE_RINGS_MAX; i++) {
+		ring_slot_t *s = &s_slots[i];
+		if (s->ring != r || !(s->live || s->dying)) continue;
+
+		if (s->refs > 0) s->refs--;
+		if (s->dying && s->refs == 0) {
+			to_free = s->ring;
+			memset(s, 0, sizeof(*s));
+		}
+		break;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	ring_free(to_free);
+}
+
+void node_rings_view(const uint8_t mac[6], int delta)
+{
+	portENTER_CRITICAL(&s_lock);
+	{
+		ring_slot_t *s = find_live(mac);
+		if (s) {
+			if (delta < 0 && s->viewers < (uint16_t)(-delta)) {
+				s->viewers = 0;
+			} else {
+				s->viewers = (uint16_t)(s->viewers + delta);
+			}
+			s->last_used_ms = ms_now();
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+}
+
+void node_rings_set_budget(uint32_t bytes)
+{
+	evicted_t ev[NODE_RINGS_MAX];
+	int n_ev = 0;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		s_budget = bytes;
+		while (s_allocated > s_budget) {
+			ring_slot_t *v = pick_victim();
+			if (!v) break;
+			evict_slot(v, &ev[n_ev++]);
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	finish_evictions(ev, n_ev);
+}
+
+uint32_t node_rings_get_budget(void)
+{
+	return s_budget;
+}
+
+uint32_t node_rings_get_allocated(void)
+{
+	return s_allocated;
+}
+
+bool node_rings_get_info(uint32_t i, node_ring_info_t *info)
+{
+	if (i >= NODE_RINGS_MAX || !info) return false;
+
+	bool ok = false;
+	log_ring_t *r = NULL;
+
+	portENTER_CRITICAL(&s_lock);
+	{
+		ring_slot_t *s = &s_slots[i];
+		if (s->live) {
+			memcpy(info->mac, s->mac, 6);
+			info->gen = s->gen;
+			info->size = s->ring->size;
+			info->viewers = s->viewers;
+			info->pinned = s->pinned;
+			info->idle_ms = ms_now() - s->last_used_ms;
+			s->refs++;
+			r = s->ring;
+			ok = true;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	if (r) {
+		info->used = log_ring_used(r);
+		info->appends = atomic_load_explicit(&r->appends, memory_order_relaxed);
+		info->resets = atomic_load_explicit(&r->resets, memory_order_relaxed);
+		node_rings_release(r);
+	}
+	return ok;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "log_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Окремий log_ring на кожну ноду, що стрімить, під спільним бюджетом пам'яті.
+	- local нода: статичний ring, закріплений (не витісняється)
+	- remote: арена з heap по NODE_RINGS_NODE_BYTES; коли бюджет вичерпано —
+	  витісняється нода без глядачів з найстарішим last_used, потім — з глядачами
+	- ring живе поки його хтось читає/пише (refs), звільняється після останнього release
+*/
+
+#ifndef NODE_RINGS_MAX
+	#define NODE_RINGS_MAX			8	// разом з local
+#endif
+
+#ifndef NODE_RINGS_NODE_BYTES
+	#define NODE_RINGS_NODE_BYTES		(8 * 1024)	// степінь двійки
+#endif
+
+#ifndef NODE_RINGS_BUDGET
+	#define NODE_RINGS_BUDGET		(64 * 1024)	// разом з local ring
+#endif
+
+// Викликається (поза lock) коли remote ring витіснено — щоб вимкнути стрім на ноді
+typedef void (*node_rings_evict_cb_t)(const uint8_t mac[6]);
+
+typedef struct {
+	uint8_t		mac[6];
+	uint32_t	gen;		// унікальний номер ring (cursor з іншого ring не валідний)
+	uint32_t	size;
+	uint32_t	used;
+	uint32_t	appends;
+	uint32_t	resets;		// скільки разів читачі отримали reset
+	uint16_t	viewers;
+	bool		pinned;
+	uint32_t	idle_ms;	// скільки часу без переглядів
+} node_ring_info_t;
+
+void		node_rings_init(const uint8_t local_mac[6], log_ring_t *local, node_rings_evict_cb_t on_evict);
+
+// Знайти ring ноди (refs++). NULL — для цієї ноди ring немає.
+log_ring_t	*node_rings_acquire(const uint8_t mac[6], uint32_t *gen);
+
+// Те саме, але створити (з витісненням), якщо нема. *created = true якщо новий.
+log_ring_t	*node_rings_open(const uint8_t mac[6], uint32_t *gen, bool *created);
+
+void		node_rings_release(log_ring_t *r);
+
+// Глядачі: пріоритет при витісненні + LRU (delta = +1 / -1)
+void		node_rings_view(const uint8_t mac[6], int delta);
+
+// Змінити загальний бюджет; зайве витісняється одразу
+void		node_rings_set_budget(uint32_t bytes);
+uint32_t	node_rings_get_budget(void);
+uint32_t	node_rings_get_allocated(void);
+
+// Для /stats: по слоту; false — слот порожній або i поза межами
+bool		node_rings_get_info(uint32_t i, node_ring_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#include "root_metrics.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+typedef struct {
+	_Atomic uint32_t	rx_pkts[ROOT_METRICS_TYPES];
+	_Atomic uint32_t	rx_bytes[ROOT_METRICS_TYPES];
+	_Atomic uint32_t	rx_short;
+	_Atomic uint32_t	rx_unknown;
+	_Atomic uint32_t	rx_errors;
+	_Atomic uint32_t	bcast_sent;
+	_Atomic uint32_t	bcast_failed;
+	_Atomic uint32_t	uart_in;
+	_Atomic uint32_t	uart_out;
+	_Atomic uint32_t	uart_overflow;
+} metrics_state_t;
+
+static metrics_state_t s_m;
+
+static inline void inc(_Atomic uint32_t *c, uint32_t v)
+{
+	atomic_fetch_add_explicit(c, v, memory_order_relaxed);
+}
+
+static inline uint32_t get(_Atomic uint32_t *c)
+{
+	return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+void root_metrics_rx(uint8_t type, size_t bytes)
+{
+	uint32_t i = type < ROOT_METRICS_TYPES - 1 ? type : ROOT_METRICS_TYPES - 1;
+
+	inc(&s_m.rx_pkts[i], 1);
+	inc(&s_m.rx_bytes[i], (uint32_t)bytes);
+}
+
+void root_metrics_rx_short(void)	{ inc(&s_m.rx_short, 1); }
+void root_metrics_rx_unknown(void)	{ inc(&s_m.rx_unknown, 1); }
+void root_metrics_rx_error(void)	{ inc(&s_m.rx_errors, 1); }
+
+void root_metrics_bcast(bool ok)
+{
+	inc(ok ? &s_m.bcast_sent : &s_m.bcast_failed, 1);
+}
+
+void root_metrics_uart_in(void)		{ inc(&s_m.uart_in, 1); }
+void root_metrics_uart_out(void)	{ inc(&s_m.uart_out, 1); }
+void root_metrics_uart_overflow(void)	{ inc(&s_m.uart_overflow, 1); }
+
+void root_metrics_get(root_metrics_t *out)
+{
+	memset(out, 0, sizeof(*out));
+
+	for (uint32_t i = 0; i < ROOT_METRICS_TYPES; i++) {
+		out->rx_pkts[i] = get(&s_m.rx_pkts[i]);
+		out->rx_bytes[i] = get(&s_m.rx_bytes[i]);
+	}
+	out->rx_short = get(&s_m.rx_short);
+	out->rx_unknown = get(&s_m.rx_unknown);
+	out->rx_errors = get(&s_m.rx_errors);
+	out->bcast_sent = get(&s_m.bcast_sent);
+	out->bcast_failed = get(&s_m.bcast_failed);
+	out->uart_in = get(&s_m.uart_in);
+	out->uart_out = get(&s_m.uart_out);
+	out->uart_overflow = get(&s_m.uart_overflow);
+}
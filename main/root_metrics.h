@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Лічильники root для /metrics (Prometheus text format).
+	- тільки atomic інкременти (relaxed), без lock: викликається з mesh RX / UART / broadcast
+	- значення монотонні з boot; швидкість рахує scraper (rate())
+*/
+
+#ifndef ROOT_METRICS_TYPES
+	#define ROOT_METRICS_TYPES		8	// mesh_pkt_hdr_t.type 0..N-2 окремо, решта — в останньому слоті
+#endif
+
+typedef struct {
+	uint32_t	rx_pkts[ROOT_METRICS_TYPES];	// пакети нашого протоколу по type
+	uint32_t	rx_bytes[ROOT_METRICS_TYPES];
+	uint32_t	rx_short;			// коротші за mesh_pkt_hdr_t
+	uint32_t	rx_unknown;			// чужий magic/version
+	uint32_t	rx_errors;			// esp_mesh_recv != ESP_OK
+	uint32_t	bcast_sent;			// root -> нода (по одному на адресата)
+	uint32_t	bcast_failed;
+	uint32_t	uart_in;			// рядків з UART
+	uint32_t	uart_out;			// рядків у UART
+	uint32_t	uart_overflow;			// рядок довший за буфер — відкинуто
+} root_metrics_t;
+
+void		root_metrics_rx(uint8_t type, size_t bytes);
+void		root_metrics_rx_short(void);
+void		root_metrics_rx_unknown(void);
+void		root_metrics_rx_error(void);
+
+// Результат одного esp_mesh_send у broadcast-циклі
+void		root_metrics_bcast(bool ok);
+
+void		root_metrics_uart_in(void);
+void		root_metrics_uart_out(void);
+void		root_metrics_uart_overflow(void);
+
+void		root_metrics_get(root_metrics_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #include "stack_monitor.h"
 
 #include <string.h>
+#include <stdlib.h>
 #include <inttypes.h>
 
 #include "freertos/FreeRTOS.h"
@@ -12,6 +13,13 @@
 
 static const char *TAG = "[STACKMON]";
 
+// CPU по тасках з останнього проходу — для stack_monitor_snapshot()
+static UBaseType_t	s_cpu_num[STACK_MONITOR_MAX_TASKS];
+static uint16_t		s_cpu_x10[STACK_MONITOR_MAX_TASKS];
+static UBaseType_t	s_cpu_count = 0;
+static uint16_t		s_load_x10  = 0;
+static portMUX_TYPE	s_cpu_lock  = portMUX_INITIALIZER_UNLOCKED;
+
 // Основна таска моніторингу
 static void stack_monitor_task(void *arg)
 {
@@ -89,6 +97,15 @@ static void stack_monitor_task(void *arg)
 			}
 
 			// Другий прохід: друкуємо стек + відсоток CPU для кожної таски
+			portENTER_CRITICAL(&s_cpu_lock);
+			s_cpu_count = count;
+			for (UBaseType_t i = 0; i < count; ++i) {
+				s_cpu_num[i] = cur[i].xTaskNumber;
+				s_cpu_x10[i] = dt_total ? (uint16_t)((uint64_t)dt_arr[i] * 1000 / dt_total) : 0;
+			}
+			s_load_x10 = dt_total ? (uint16_t)((dt_total - dt_idle) * 1000 / dt_total) : 0;
+			portEXIT_CRITICAL(&s_cpu_lock);
+
 			for (UBaseType_t i = 0; i < count; ++i) {
 				TaskStatus_t *c = &cur[i];
 				const char *name = c->pcTaskName;
@@ -131,6 +148,57 @@ static void stack_monitor_task(void *arg)
 	}
 }
 
+size_t stack_monitor_snapshot(stack_monitor_task_t *out, size_t max, uint32_t *total)
+{
+	// TaskStatus_t масив не на стеку — викликається з HTTP таски
+	TaskStatus_t *st = (TaskStatus_t *)malloc(STACK_MONITOR_MAX_TASKS * sizeof(TaskStatus_t));
+	if (!st) {
+		return 0;
+	}
+
+	uint32_t total_time = 0;
+	UBaseType_t count = uxTaskGetSystemState(st, STACK_MONITOR_MAX_TASKS, &total_time);
+	if (total) {
+		*total = total_time;
+	}
+
+	size_t n = 0;
+	for (UBaseType_t i = 0; i < count && n < max; ++i) {
+		stack_monitor_task_t *t = &out[n++];
+		const char *name = st[i].pcTaskName;
+		if (!name || !name[0]) {
+			name = "noname";
+		}
+
+		strncpy(t->name, name, sizeof(t->name) - 1);
+		t->name[sizeof(t->name) - 1] = '\0';
+		t->prio       = st[i].uxCurrentPriority;
+		t->stack_free = (uint32_t)(st[i].usStackHighWaterMark * sizeof(StackType_t));
+		t->run_time   = st[i].ulRunTimeCounter;
+		t->cpu_x10    = 0;
+
+		portENTER_CRITICAL(&s_cpu_lock);
+		for (UBaseType_t j = 0; j < s_cpu_count; ++j) {
+			if (s_cpu_num[j] == st[i].xTaskNumber) {
+				t->cpu_x10 = s_cpu_x10[j];
+				break;
+			}
+		}
+		portEXIT_CRITICAL(&s_cpu_lock);
+	}
+
+	free(st);
+	return n;
+}
+
+uint16_t stack_monitor_cpu_load_x10(void)
+{
+	portENTER_CRITICAL(&s_cpu_lock);
+	uint16_t v = s_load_x10;
+	portEXIT_CRITICAL(&s_cpu_lock);
+	return v;
+}
+
 // Публічний старт монітора
 void stack_monitor_start(UBaseType_t priority)
 {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
@@ -9,6 +12,20 @@ extern "C" {
 // Стартує окрему таску моніторингу стеків + CPU usage
 void stack_monitor_start(UBaseType_t priority);
 
+typedef struct {
+	char		name[configMAX_TASK_NAME_LEN];
+	UBaseType_t	prio;
+	uint32_t	stack_free;	// байт, мінімум за весь час (high water mark)
+	uint32_t	run_time;	// ulRunTimeCounter — лічильник, з часом переповнюється
+	uint16_t	cpu_x10;	// CPU % * 10 за останній період монітора (0 — ще не рахувався)
+} stack_monitor_task_t;
+
+// Поточний знімок тасок (для /metrics). Повертає кількість у out (<= max); *total — сумарний run time.
+size_t stack_monitor_snapshot(stack_monitor_task_t *out, size_t max, uint32_t *total);
+
+// CPU load без idle за останній період монітора, % * 10
+uint16_t stack_monitor_cpu_load_x10(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include "time_sync.h"
+#include "log_clock.h"
 
 #include <time.h>
 #include <sys/time.h>
@@ -49,10 +50,10 @@ void time_sync_format(char *out, size_t out_len)
 		return;
 	}
 
-	time_t now = 0;
-	struct tm t;
-	time(&now);
-	localtime_r(&now, &t);
-
-	strftime(out, out_len, "%Y-%m-%d %H:%M:%S", &t);
+	// той самий кеш секунди, що й у лог-хуків
+	uint32_t sec;
+	uint16_t ms;
+	if (!log_clock_now(&sec, &ms) || log_clock_format(sec, out, out_len) == 0) {
+		snprintf(out, out_len, "no-time");
+	}
 }
@@ -10,6 +10,7 @@
 #include "freertos/task.h"
 
 #include "mesh_root_bcast.h"   // тут оголошено mesh_root_broadcast_text()
+#include "root_metrics.h"
 
 static const char *TAG = "uart_bridge";
 
@@ -77,6 +78,7 @@ static void uart_bridge_task(void *arg)
 
 					if (L > 0) {
 						ESP_LOGI(TAG, "RX UART: '%s'", line);
+						root_metrics_uart_in();
 						// розкидуємо по всій mesh-мережі
 						mesh_root_broadcast_text(line);
 					}
@@ -91,6 +93,7 @@ static void uart_bridge_task(void *arg)
 
 			// якщо буфер забитий без '\n' – просто обнуляємо
 			if (len >= UART_BRIDGE_RX_BUF - 1) {
+				root_metrics_uart_overflow();
 				len = 0;
 			}
 		}
@@ -177,6 +180,7 @@ void uart_bridge_send_line(const char *text)
 	// додаємо '\n', щоб з того боку приймалося як окрема строка
 	const char nl = '\n';
 	uart_write_bytes(UART_BRIDGE_PORT, &nl, 1);
+	root_metrics_uart_out();
 
 	ESP_LOGI(TAG, "TX UART: '%s'", text);
 }